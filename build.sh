@@ -26,6 +26,11 @@ CFLAGS=$(list "
     -Werror
 ")
 
+# appended to CFLAGS by the unity build, later -O wins
+UNITY_CFLAGS=$(list "
+    -O2
+")
+
 CPPFLAGS=$(list "
     -I.
     -Ldeps
@@ -45,6 +50,7 @@ LIBS=$(list "
     -ldynarr_static
     -lvector_static
     -lm
+    -lpthread
 ")
 
 init_subdirs() {
@@ -217,6 +223,31 @@ build_executable() {
     return 0
 }
 
+# Builds executable from one translation unit including all its sources,
+# so calls across modules can be inlined even without LTO.
+build_unity() {
+    [ $# -eq 0 ] && { echo "! build_unity() expects source. " >&2 && exit 1 ;}
+    local source="$1"
+    local target="$( echo "${source}" | sed 's/\.c//' )_unity"
+    echo "Target: $target" >&2
+
+    local deps=$( collect_dependencies ${source} )
+    local sources="${source} $( h2c ${deps} )"
+    local unity="${BUILD_DIR}/${target}.c"
+
+    # feature macros have to come before the first system header
+    {
+        echo "#define _GNU_SOURCE"
+        for src in ${sources}; do echo "#include \"${src}\""; done
+    } > ${unity}
+
+    local cmd="${CC} ${CPPFLAGS} ${CFLAGS} ${UNITY_CFLAGS} ${unity} -o ${BUILD_DIR}/${target} ${LIBS}"
+    ${cmd} || return $? # return on failure
+    echo ${cmd} >&2
+
+    return 0
+}
+
 help() {
     local compile_desc="compile [<target>]      - compile specific target. default target: 'tifc'"
     local check_desc="check [<target|object>] - check sum of the dependencies."
@@ -226,7 +257,7 @@ help() {
     case "$1" in
         compile)
             echo "${compile_desc}"
-            echo "Available targets:\n\ttifc\n\ttests"
+            echo "Available targets:\n\ttifc\n\ttifc_unity\n\ttests"
         ;;
         check)
             echo "\t${check_desc}"
@@ -260,6 +291,10 @@ main() {
                     { build_executable 'tifc.c' ;}
                     [ $? != 0 ] && exit $?
                 ;;
+                tifc_unity)
+                    { build_unity 'tifc.c' ;}
+                    [ $? != 0 ] && exit $?
+                ;;
                 tests)
                     local tests=$( collect_tests )
                     for _test_ in ${tests}; do
@@ -0,0 +1,150 @@
+#define _GNU_SOURCE // memfd_create, posix_openpt
+
+#include "backend.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <termios.h>
+#include <unistd.h>
+
+int backend_open_tty(backend_t *const backend)
+{
+    // O_NONBLOCK on stdout itself would leak into stdin and the parent shell
+    const char *tty = ttyname(STDOUT_FILENO);
+    if (!tty) return errno;
+
+    int fd = open(tty, O_WRONLY | O_NONBLOCK | O_CLOEXEC | O_NOCTTY);
+    if (-1 == fd)
+    {
+        perror("backend_open_tty");
+        return errno;
+    }
+    *backend = (backend_t){
+        .kind = BACKEND_TTY,
+        .open = true,
+        .fd = fd,
+    };
+    return 0;
+}
+
+int backend_open_memory(backend_t *const backend, disp_pos_t size)
+{
+    int fd = memfd_create("tifc-display", MFD_CLOEXEC);
+    if (-1 == fd)
+    {
+        perror("backend_open_memory");
+        return errno;
+    }
+    *backend = (backend_t){
+        .kind = BACKEND_MEMORY,
+        .open = true,
+        .fd = fd,
+        .size = size,
+    };
+    return 0;
+}
+
+int backend_open_pty(backend_t *const backend, disp_pos_t size)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (-1 == master || -1 == grantpt(master) || -1 == unlockpt(master))
+    {
+        int error = errno;
+        perror("backend_open_pty");
+        if (-1 != master) close(master);
+        return error;
+    }
+
+    struct winsize ws = {.ws_col = size.x, .ws_row = size.y};
+    ioctl(master, TIOCSWINSZ, &ws);
+
+    int slave = open(ptsname(master), O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+    if (-1 == slave)
+    {
+        int error = errno;
+        perror("backend_open_pty");
+        close(master);
+        return error;
+    }
+
+    // frames reach the master side byte for byte
+    struct termios attr;
+    tcgetattr(slave, &attr);
+    cfmakeraw(&attr);
+    tcsetattr(slave, TCSANOW, &attr);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    *backend = (backend_t){
+        .kind = BACKEND_PTY,
+        .open = true,
+        .fd = slave,
+        .peer_fd = master,
+        .size = size,
+    };
+    return 0;
+}
+
+void backend_close(backend_t *const backend)
+{
+    if (!backend->open) return;
+
+    close(backend->fd);
+    if (BACKEND_PTY == backend->kind) close(backend->peer_fd);
+    *backend = (backend_t){0};
+}
+
+int backend_fd(const backend_t *const backend)
+{
+    return backend->open ? backend->fd : STDOUT_FILENO;
+}
+
+disp_pos_t backend_size(const backend_t *const backend)
+{
+    if (BACKEND_MEMORY == backend->kind) return backend->size;
+
+    struct winsize ws = {0};
+    ioctl(backend_fd(backend), TIOCGWINSZ, &ws);
+    return (disp_pos_t){ws.ws_col, ws.ws_row};
+}
+
+void backend_set_blocking(backend_t *const backend)
+{
+    if (!backend->open) return;
+    fcntl(backend->fd, F_SETFL, fcntl(backend->fd, F_GETFL) & ~O_NONBLOCK);
+}
+
+ssize_t backend_read(backend_t *const backend, void *const buffer, size_t size)
+{
+    switch (backend->kind)
+    {
+        case BACKEND_MEMORY:
+        {
+            ssize_t bytes = pread(backend->fd, buffer, size, backend->read_offset);
+            if (bytes <= 0) return bytes;
+            backend->read_offset += bytes;
+
+            // everything is consumed, start over instead of growing forever
+            if (backend->read_offset == lseek(backend->fd, 0, SEEK_END))
+            {
+                (void) ftruncate(backend->fd, 0);
+                lseek(backend->fd, 0, SEEK_SET);
+                backend->read_offset = 0;
+            }
+            return bytes;
+        }
+        case BACKEND_PTY:
+        {
+            ssize_t bytes = read(backend->peer_fd, buffer, size);
+            if (-1 == bytes && EAGAIN == errno) return 0;
+            return bytes;
+        }
+        case BACKEND_TTY:
+        break;
+    }
+    errno = ENOTSUP;
+    return -1;
+}
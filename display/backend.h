@@ -0,0 +1,64 @@
+#ifndef _BACKEND_H_
+#define _BACKEND_H_
+
+#include "display_types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef enum
+{
+    BACKEND_TTY,    /* terminal the process runs in        */
+    BACKEND_MEMORY, /* in-memory sink with a virtual size  */
+    BACKEND_PTY,    /* pseudo terminal pair, headless tty  */
+}
+backend_kind_t;
+
+/*
+ * Where frames are written and where the screen size comes from.
+ * Zero initialized backend is the terminal on blocking stdout.
+ */
+typedef struct
+{
+    backend_kind_t kind;
+    bool       open;
+    int        fd;      /* frames are written here                    */
+    int        peer_fd; /* pty: master side the frames are read from  */
+    disp_pos_t size;    /* virtual screen size of memory and pty      */
+    off_t      read_offset; /* memory: output consumed by backend_read */
+}
+backend_t;
+
+/*
+ * Reopens the terminal for output in non-blocking mode.
+ * Separate open file description leaves stdin blocking.
+ * Returns 0 or errno.
+ */
+int backend_open_tty(backend_t *const backend);
+
+/* Sink keeping frames in memory, to render without a terminal. Returns 0 or errno */
+int backend_open_memory(backend_t *const backend, disp_pos_t size);
+
+/* Pseudo terminal of the given size, output is read from the master side. Returns 0 or errno */
+int backend_open_pty(backend_t *const backend, disp_pos_t size);
+
+void backend_close(backend_t *const backend);
+
+/* Descriptor frames are written to */
+int backend_fd(const backend_t *const backend);
+
+/* Screen size, terminal backend asks the kernel every time */
+disp_pos_t backend_size(const backend_t *const backend);
+
+/* Makes writes wait, so everything pending can be written out before exit */
+void backend_set_blocking(backend_t *const backend);
+
+/*
+ * Reads output written so far, for memory and pty backends.
+ * Memory backend discards output once it is read completely.
+ * Returns amount of bytes read, 0 when nothing is pending or -1 on error.
+ */
+ssize_t backend_read(backend_t *const backend, void *const buffer, size_t size);
+
+#endif//_BACKEND_H_
@@ -3,10 +3,12 @@
 
 #include <wchar.h>
 
-#define BORDER_STYLE_1 ((style_t){ .seq = ESC"[91m" })
-#define BORDER_STYLE_2 ((style_t){ .seq = ESC"[5;38;5;16;48;5;73m" })
-#define BORDER_STYLE_3 ((style_t){ .seq = ESC"[6;38;5;202;48;5;23m" })
-#define BORDER_STYLE_4 ((style_t){ .seq = ESC"[31m" })
+#define BORDER_STYLE_1 ((style_t){ .fg = SGR_COLOR_BASIC(9) })
+#define BORDER_STYLE_2 ((style_t){ .attrs = SGR_BLINK, \
+                                   .fg = SGR_COLOR_INDEX(16), .bg = SGR_COLOR_INDEX(73) })
+#define BORDER_STYLE_3 ((style_t){ .attrs = SGR_RAPID_BLINK, \
+                                   .fg = SGR_COLOR_INDEX(202), .bg = SGR_COLOR_INDEX(23) })
+#define BORDER_STYLE_4 ((style_t){ .fg = SGR_COLOR_BASIC(1) })
 
 #define BORDER_SET_SIZE 6
 typedef struct
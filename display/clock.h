@@ -0,0 +1,18 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#define NS_IN_SEC 1000000000ull
+
+/* Monotonic time in nanoseconds, frames are paced and measured with it */
+static inline uint64_t
+clock_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * NS_IN_SEC + ts.tv_nsec;
+}
+
+#endif//_CLOCK_H_
@@ -0,0 +1,99 @@
+#include "cluster.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CLUSTER_INITIAL_CAP 64
+
+static const cluster_t empty_cluster = {.base = U' '};
+
+static size_t cluster_hash(const cluster_t *const cluster);
+static bool same_cluster(const cluster_t *const a, const cluster_t *const b);
+static void grow_clusters(cluster_table_t *const table);
+
+void cluster_table_deinit(cluster_table_t *const table)
+{
+    free(table->clusters);
+    free(table->slots);
+    *table = (cluster_table_t){0};
+}
+
+uint32_t cluster_table_intern(cluster_table_t *const table, const cluster_t *const cluster)
+{
+    if (!table->slots) grow_clusters(table);
+
+    const size_t mask = table->capacity * 2 - 1; // slots are twice the capacity
+    size_t slot = cluster_hash(cluster) & mask;
+    for (; table->slots[slot]; slot = (slot + 1) & mask)
+    {
+        const uint32_t id = table->slots[slot] - 1;
+        if (same_cluster(cluster, &table->clusters[id])) return id;
+    }
+
+    if (table->count == CLUSTER_MAX_COUNT) return CLUSTER_NONE;
+
+    if (table->count == table->capacity)
+    {
+        grow_clusters(table);
+        return cluster_table_intern(table, cluster); // slots were rehashed
+    }
+
+    const uint32_t id = table->count++;
+    table->clusters[id] = *cluster;
+    table->slots[slot] = id + 1;
+    return id;
+}
+
+const cluster_t *cluster_table_get(const cluster_table_t *const table, uint32_t id)
+{
+    if (id >= table->count) return &empty_cluster;
+    return &table->clusters[id];
+}
+
+static size_t cluster_hash(const cluster_t *const cluster)
+{
+    // FNV-1a over the code points in use
+    size_t hash = (14695981039346656037ull ^ cluster->base) * 1099511628211ull;
+    for (uint32_t i = 0; i < cluster->count; ++i)
+    {
+        hash ^= cluster->marks[i];
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+static bool same_cluster(const cluster_t *const a, const cluster_t *const b)
+{
+    if (a->base != b->base || a->count != b->count) return false;
+    for (uint32_t i = 0; i < a->count; ++i)
+    {
+        if (a->marks[i] != b->marks[i]) return false;
+    }
+    return true;
+}
+
+static void grow_clusters(cluster_table_t *const table)
+{
+    const size_t capacity = table->capacity ? table->capacity * 2 : CLUSTER_INITIAL_CAP;
+    cluster_t *clusters = realloc(table->clusters, capacity * sizeof(cluster_t));
+    uint32_t *slots = calloc(capacity * 2, sizeof(uint32_t));
+    if (!clusters || !slots)
+    {
+        perror("cluster_table");
+        exit(EXIT_FAILURE);
+    }
+
+    const size_t mask = capacity * 2 - 1;
+    for (size_t id = 0; id < table->count; ++id)
+    {
+        size_t slot = cluster_hash(&clusters[id]) & mask;
+        while (slots[slot]) slot = (slot + 1) & mask;
+        slots[slot] = (uint32_t) id + 1;
+    }
+
+    free(table->slots);
+    table->clusters = clusters;
+    table->slots = slots;
+    table->capacity = capacity;
+}
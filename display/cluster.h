@@ -0,0 +1,47 @@
+#ifndef _CLUSTER_H_
+#define _CLUSTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CLUSTER_MAX_MARKS 4                 /* further combining marks are dropped */
+#define CLUSTER_MAX_COUNT (UINT16_MAX + 1)
+#define CLUSTER_NONE      UINT32_MAX
+
+/* Base character followed by combining marks, shown in one cell */
+typedef struct
+{
+    uint32_t base;
+    uint32_t count;                    /* marks in use */
+    uint32_t marks[CLUSTER_MAX_MARKS];
+}
+cluster_t;
+
+/*
+ * Interns clusters so a cell holds an id of the same size as a code point.
+ * Zero initialized table is valid and empty.
+ */
+typedef struct
+{
+    cluster_t *clusters; /* id -> cluster                        */
+    uint32_t  *slots;    /* open addressing: id + 1, 0 for empty */
+    size_t     count;
+    size_t     capacity;
+}
+cluster_table_t;
+
+void cluster_table_deinit(cluster_table_t *const table);
+
+/*
+ * Returns id of the cluster, adding it to the table when not present.
+ * Returns CLUSTER_NONE when table is full.
+ */
+uint32_t
+cluster_table_intern(cluster_table_t *const table,
+        const cluster_t *const cluster);
+
+const cluster_t *
+cluster_table_get(const cluster_table_t *const table,
+        uint32_t id);
+
+#endif//_CLUSTER_H_
@@ -1,180 +1,631 @@
 #include "display.h"
+#include "clock.h"
+#include "utf8.h"
 
 #include <string.h>
 #include <stdio.h>
-#include <sys/ioctl.h>
+#include <stdlib.h>
+#include <sys/signalfd.h>
 #include <signal.h>
+#include <time.h>
 #include <assert.h>
+#include <errno.h>
+#include <unistd.h>
 
 static int prev_buffer(const int active);
-static bool disp_diff(const disp_char_t *const a, const disp_char_t *const b);
-static void display_swap_buffers(display_t *const display);
-static disp_pos_t get_terminal_size(void);
-static void set_border(display_t *const display, wchar_t border_char, disp_pos_t pos, style_t style);
+static disp_char_t *row_at(const display_t *const display, int buffer, unsigned int line);
+static display_clip_t current_clip(const display_t *const display);
+static bool clip_to_screen(const display_t *const display, long long x1, long long y1, long long x2, long long y2, disp_area_t *const area);
+static void write_row(display_t *const display, disp_char_t cell, unsigned int line, unsigned int first, unsigned int last);
+static void copy_cells(display_t *const display, unsigned int line, unsigned int x, const disp_char_t *const cells, unsigned int count);
+static int present(display_t *const display);
+static void collect_written(display_t *const display);
+static void record_frame(display_t *const display);
+static void scroll_screen(display_t *const display);
+static void scroll_mirror(display_t *const display, scroll_region_t region);
+static void shift_lines(display_t *const display, const uint64_t *const now, const uint64_t *const before);
+static bool is_line_shifted(const disp_char_t *const now, const disp_char_t *const before, unsigned int cols, int shift);
+static void set_border(display_t *const display, wchar_t border_char, unsigned int x, unsigned int y, style_id_t style);
+static bool same_cell(const disp_char_t *const a, const disp_char_t *const b);
+static void set_glyph(display_t *const display, uint32_t ch, unsigned int width, disp_pos_t pos);
+static void seal(display_t *const display, unsigned int line, unsigned int x);
+static unsigned int put_cell(display_t *const display, const disp_char_t *const row, unsigned int col);
 
-struct resize_handler
+void display_set_resize_handler(display_t *const display, resize_hook_with_data_t resize_hook)
 {
-    bool resize_detected;
-    resize_hook_with_data_t resize_hook;
+    display->resize_hook = resize_hook;
+    if (!display->has_resize_fd)
+    {
+        // signal is read from the descriptor, so it must not be delivered
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGWINCH);
+        sigprocmask(SIG_BLOCK, &mask, NULL);
+
+        int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (-1 == fd)
+        {
+            perror("signalfd");
+            sigprocmask(SIG_UNBLOCK, &mask, NULL);
+        }
+        else
+        {
+            display->resize_fd = fd;
+            display->has_resize_fd = true;
+        }
+    }
+    display_resize(display, backend_size(&display->backend));
+    // whatever the terminal showed before is printed over
+    display->reprint = true;
 }
-volatile g_resize_handler;
 
-static void resize_handler(int signo, siginfo_t *info, void *ctx)
+int display_resize_fd(const display_t *const display)
 {
-    (void) signo; (void) info; (void) ctx;
-    g_resize_handler.resize_detected = true;
+    return display->has_resize_fd ? display->resize_fd : -1;
 }
 
-void display_set_resize_handler(display_t *const display, resize_hook_with_data_t resize_hook)
+void display_on_resize_signal(display_t *const display)
 {
-    g_resize_handler.resize_hook = resize_hook;
-    struct sigaction action = {0};
-    action.sa_sigaction = resize_handler;
-    sigaction(SIGWINCH, &action, NULL);
-    display->size = get_terminal_size();
-    printf(CLEAR);
+    if (!display->has_resize_fd) return;
+
+    // signals coalesce, one size query covers all of them
+    struct signalfd_siginfo info;
+    bool resized = false;
+    while (sizeof(info) == read(display->resize_fd, &info, sizeof(info)))
+    {
+        resized = true;
+    }
+    if (!resized) return;
+
+    display_resize(display, backend_size(&display->backend));
+    if (display->resize_hook.hook)
+    {
+        display->resize_hook.hook(display, display->resize_hook.data);
+    }
+    display->reprint = true;
 }
 
 void display_render(display_t *const display)
 {
-    disp_pos_t screen = get_terminal_size();
+    if (display->encoder.draining && EAGAIN == present(display))
+    {
+        // changes stay dirty and go out with the next frame
+        display_invalidate(display);
+        return;
+    }
+
+    const uint64_t start = clock_now_ns();
+    const disp_pos_t screen = display->size;
+    display->frame = (frame_stats_t){0};
     disp_area_t screen_area = {
         .second = {
             .x = screen.x - 1,
             .y = screen.y - 1
         }
     };
-    printf(SHOW_CURSOR);
+    encoder_begin_frame(&display->encoder, screen);
+    if (display->encoder.caps.sync_output)
+    {
+        // terminal holds the frame back until it is complete, no tearing
+        encoder_put_seq(&display->encoder, SYNC_OUTPUT_BEGIN, ENCODER_SEQ_MODE);
+    }
+    encoder_put_seq(&display->encoder, SHOW_CURSOR, ENCODER_SEQ_MODE);
     display_render_area(display, screen_area);
+    encoder_end_frame(&display->encoder);
+    if (display->encoder.caps.sync_output)
+    {
+        encoder_put_seq(&display->encoder, SYNC_OUTPUT_END, ENCODER_SEQ_MODE);
+    }
+
+    display->encoder.stats.encode_ns = clock_now_ns() - start;
+    record_frame(display);
+
+    fflush(stdout); // keep order with output printed by the hooks
+    display->invalidated = false;
+    (void) present(display);
+    pacer_presented(&display->pacer);
+}
+
+void display_invalidate(display_t *const display)
+{
+    // frame waiting for busy output merges into the one after it
+    if (display->encoder.draining && !display->invalidated) ++display->encoder.stats.dropped;
+    display->invalidated = true;
+}
+
+bool display_needs_render(const display_t *const display)
+{
+    return display->invalidated && !display->encoder.draining;
+}
+
+int display_open_output(display_t *const display)
+{
+    if (display->backend.open) return 0;
+    return backend_open_tty(&display->backend);
+}
+
+void display_set_backend(display_t *const display, backend_t backend)
+{
+    backend_close(&display->backend);
+    display->backend = backend;
+    display_resize(display, backend_size(&display->backend));
+}
+
+int display_output_fd(const display_t *const display)
+{
+    return backend_fd(&display->backend);
+}
+
+int display_start_writer(display_t *const display)
+{
+    return writer_start(&display->writer, display_output_fd(display));
+}
+
+int display_writer_fd(const display_t *const display)
+{
+    return display->writer.running ? display->writer.done_fd : -1;
+}
+
+void display_on_output_ready(display_t *const display)
+{
+    if (display->writer.running)
+    {
+        writer_on_done(&display->writer);
+        collect_written(display);
+    }
+    if (display->encoder.draining)
+    {
+        (void) present(display);
+    }
+}
+
+int display_set_max_fps(display_t *const display, unsigned int max_fps)
+{
+    return pacer_set_max_fps(&display->pacer, max_fps);
+}
+
+bool display_frame_due(display_t *const display)
+{
+    return pacer_frame_due(&display->pacer);
+}
+
+int display_frame_timer_fd(const display_t *const display)
+{
+    return display->pacer.has_timer ? display->pacer.timerfd : -1;
+}
+
+void display_on_frame_timer(display_t *const display)
+{
+    pacer_on_timer(&display->pacer);
+}
+
+size_t display_missed_deadlines(const display_t *const display)
+{
+    return display->pacer.missed;
+}
 
+const frame_stats_t *display_frame_stats(const display_t *const display, size_t age)
+{
+    return stats_frame(&display->stats, age);
+}
+
+stats_histogram_t display_stats_histogram(const display_t *const display, stat_metric_t metric)
+{
+    return stats_histogram(&display->stats, metric);
+}
+
+void display_query_caps(display_t *const display, termcaps_typed_t *const typed)
+{
     fflush(stdout);
+    display->encoder.caps = termcaps_query(STDIN_FILENO, STDOUT_FILENO, TERMCAPS_TIMEOUT_MS, typed);
 }
 
 void display_render_area(display_t *const display, disp_area_t area)
 {
+    encoder_t *const encoder = &display->encoder;
     int prev = prev_buffer(display->active);
-    dispbuf_ptr_t active = display->buffers[display->active];
-    dispbuf_ptr_t previous = display->buffers[prev];
+    const bool force_reprint = display->reprint;
+    display->reprint = false;
 
-    bool force_reprint = false;
-    if (g_resize_handler.resize_detected)
-    {
-        display->size = get_terminal_size();
+    if (0 == display->size.x || 0 == display->size.y) return;
+
+    // look style up only when it changes between consecutive cells
+    style_id_t last_style = STYLE_DEFAULT_ID;
+    const style_t *style = style_table_get(&display->styles, last_style);
 
-        volatile resize_hook_with_data_t *resize_hook = &g_resize_handler.resize_hook;
-        resize_hook->hook(display, resize_hook->data);
+    if (area.second.x >= display->size.x) area.second.x = display->size.x - 1;
+    if (area.second.y >= display->size.y) area.second.y = display->size.y - 1;
 
-        force_reprint = true;
-        g_resize_handler.resize_detected = false;
+    // panning moves the whole screen, scrolling it is cheaper than a repaint
+    if (!force_reprint
+        && 0 == area.first.x && area.second.x + 1 == display->size.x
+        && 0 == area.first.y && area.second.y + 1 == display->size.y)
+    {
+        scroll_screen(display);
     }
 
-    for (unsigned int line = area.first.y;
-            line <= area.second.y && line < display->size.y;
-            ++line)
+    for (unsigned int line = area.first.y; line <= area.second.y; ++line)
     {
-        for (unsigned int col = area.first.x;
-                col <= area.second.x && col < display->size.x;
-                ++col)
+        disp_span_t *const dirty = &display->dirty[line];
+        disp_span_t span = {area.first.x, area.second.x};
+        if (!force_reprint)
+        {
+            // visit only columns touched since the last render
+            if (IS_EMPTY_SPAN(dirty)) continue;
+            if (span.first < dirty->first) span.first = dirty->first;
+            if (span.last > dirty->last) span.last = dirty->last;
+            if (IS_EMPTY_SPAN(&span)) continue;
+        }
+        display->frame.values[STAT_CELLS_SCANNED] += span.last - span.first + 1;
+
+        const disp_char_t *const active = row_at(display, display->active, line);
+        disp_char_t *const previous = row_at(display, prev, line);
+
+        disp_span_t *const runs = display->runs;
+        size_t runs_amount = 1;
+        if (force_reprint) runs[0] = span;
+        else runs_amount = display->row_diff(active, previous, span.first, span.last, runs);
+
+        for (size_t r = 0; r < runs_amount; ++r)
         {
-            if (force_reprint
-                || disp_diff(&active[line][col], &previous[line][col]))
+            // wide glyph is printed whole, even when one half of it changed
+            disp_span_t run = runs[r];
+            if (run.first > 0 && ((active[run.first - 1].flags & CELL_WIDE)
+                        || (active[run.first].flags & CELL_CONTINUATION))) --run.first;
+            if (run.last + 1u < display->size.x && ((active[run.last].flags & CELL_WIDE)
+                        || (active[run.last + 1].flags & CELL_CONTINUATION))) ++run.last;
+
+            for (unsigned int col = run.first; col <= run.last;)
             {
-                if (active[line][col].style.seq)
-                    printf("%s", active[line][col].style.seq);
-                printf(ESC"[%d;%dH%lc", line + 1, col + 1, active[line][col].ch);
-                printf(ESC RESET_STYLE);
+                // cells repeated in a row are printed as one group
+                unsigned int end = col + 1;
+                while (end <= run.last && 0 == memcmp(&active[end], &active[col], sizeof(disp_char_t)))
+                {
+                    ++end;
+                }
+
+                if (active[col].style != last_style)
+                {
+                    last_style = active[col].style;
+                    style = style_table_get(&display->styles, last_style);
+                }
+                encoder_move_to(encoder, (disp_pos_t){col, line});
+                encoder_set_style(encoder, style);
+                if (active[col].flags) // wide glyphs and clusters
+                {
+                    col += put_cell(display, active, col);
+                    continue;
+                }
+                if (U' ' == active[col].ch)
+                {
+                    encoder_put_blanks(encoder, end - col, end == display->size.x);
+                }
+                else
+                {
+                    encoder_put_char_repeated(encoder, active[col].ch, end - col);
+                }
+                col = end;
             }
+            memcpy(&previous[run.first], &active[run.first], (run.last - run.first + 1) * sizeof(disp_char_t));
+            display->frame.values[STAT_CELLS_CHANGED] += run.last - run.first + 1;
+        }
+
+        // row is in sync with the screen unless area cut the dirty span
+        if (span.first <= dirty->first && span.last >= dirty->last)
+        {
+            *dirty = EMPTY_SPAN;
         }
     }
+}
 
-    display_swap_buffers(display);
+
+void display_set_glyph(display_t *const display, wint_t ch, disp_pos_t pos)
+{
+    if (!display_visible_cell(display, &pos)) return;
+    set_glyph(display, ch, glyph_width(ch), pos);
 }
 
+style_id_t display_intern_style(display_t *const display, style_t style)
+{
+    return style_table_intern(&display->styles, &style);
+}
 
-void display_set_char(display_t *const display, wint_t ch, disp_pos_t pos)
+void display_draw_border(display_t *const display, style_t border_style, border_set_t border, disp_area_t area)
 {
-    display->buffers[display->active][pos.y][pos.x].ch = ch;
+    display_draw_rect(display, display_intern_style(display, border_style), border, area);
 }
 
-void display_set_style(display_t *const display, style_t style, disp_pos_t pos)
+void display_fill_area(display_t *const display, style_t fill_style, disp_area_t area)
 {
-    display->buffers[display->active][pos.y][pos.x].style = style;
+    const disp_char_t cell = {.ch = U' ', .style = display_intern_style(display, fill_style)};
+    display_fill_rect(display, cell, area);
 }
 
-void display_draw_border(display_t *const display, style_t style, border_set_t border, disp_area_t area)
+bool display_push_clip(display_t *const display, disp_rect_t rect)
 {
-    for (unsigned int y = area.first.y; y <= area.second.y; ++y)
+    if (DISPLAY_MAX_CLIPS == display->clip_depth)
     {
-        for (unsigned int x = area.first.x; x <= area.second.x; ++x)
-        {
-            disp_pos_t pos = {x, y};
-            if (x == area.first.x && y == area.first.y)
-                set_border(display, border.top_left, pos, style);
-            else if (x == area.second.x && y == area.first.y)
-                set_border(display, border.top_right, pos, style);
-            else if (x == area.second.x && y == area.second.y)
-                set_border(display, border.bot_right, pos, style);
-            else if (x == area.first.x && y == area.second.y)
-                set_border(display, border.bot_left, pos, style);
-            else if (x == area.first.x || x == area.second.x)
-                set_border(display, border.vertical, pos, style);
-            else if (y == area.first.y || y == area.second.y)
-                set_border(display, border.horizontal, pos, style);
-        }
+        ++display->clip_overflow;
+        return false;
+    }
+
+    const display_clip_t parent = current_clip(display);
+    display_clip_t clip = {
+        .x = parent.x + rect.x,
+        .y = parent.y + rect.y,
+    };
+    clip.empty = 0 == rect.width || 0 == rect.height
+        || !clip_to_screen(display, rect.x, rect.y,
+                (long long) rect.x + rect.width - 1,
+                (long long) rect.y + rect.height - 1,
+                &clip.area);
+    display->clips[display->clip_depth++] = clip;
+    return !clip.empty;
+}
+
+void display_pop_clip(display_t *const display)
+{
+    if (display->clip_overflow) --display->clip_overflow;
+    else if (display->clip_depth) --display->clip_depth;
+}
+
+void display_fill_row_span(display_t *const display, disp_char_t cell, unsigned int line, disp_span_t span)
+{
+    disp_area_t area;
+    if (IS_EMPTY_SPAN(&span) || !clip_to_screen(display, span.first, line, span.last, line, &area)) return;
+    write_row(display, cell, area.first.y, area.first.x, area.second.x);
+}
+
+void display_fill_col_span(display_t *const display, disp_char_t cell, unsigned int col, disp_span_t span)
+{
+    disp_area_t area;
+    if (IS_EMPTY_SPAN(&span) || !clip_to_screen(display, col, span.first, col, span.last, &area)) return;
+
+    disp_char_t *cur = &row_at(display, display->active, area.first.y)[area.first.x];
+    for (unsigned int line = area.first.y; line <= area.second.y; ++line, cur += display->size.x)
+    {
+        if (same_cell(cur, &cell)) continue;
+        *cur = cell;
+        display_mark_dirty(display, line, area.first.x);
+        seal(display, line, area.first.x);
+        seal(display, line, area.first.x + 1);
     }
 }
 
-void display_fill_area(display_t *const display, style_t style, disp_area_t area)
+void display_fill_rect(display_t *const display, disp_char_t cell, disp_area_t area)
 {
-    for (unsigned int y = area.first.y; y <= area.second.y; ++y)
+    disp_area_t screen;
+    if (!clip_to_screen(display, area.first.x, area.first.y, area.second.x, area.second.y, &screen)) return;
+    for (unsigned int line = screen.first.y; line <= screen.second.y; ++line)
     {
-        for (unsigned int x = area.first.x; x <= area.second.x; ++x)
-        {
-            disp_pos_t pos = {x, y};
-            display_set_style(display, style, pos);
-            display_set_char(display, U' ', pos);
-        }
+        write_row(display, cell, line, screen.first.x, screen.second.x);
     }
 }
 
-void display_draw_string(display_t *const display, unsigned int size, const char string[size], disp_pos_t pos, style_t style)
+void display_draw_rect(display_t *const display, style_id_t style, border_set_t border, disp_area_t area)
 {
-    for (unsigned int i = 0; i < size; ++i, ++pos.x)
+    const disp_pos_t first = area.first;
+    const disp_pos_t second = area.second;
+    disp_area_t screen;
+    if (!clip_to_screen(display, first.x, first.y, second.x, second.y, &screen)) return;
+
+    const disp_char_t horizontal = {.ch = border.horizontal, .style = style};
+    const disp_char_t vertical = {.ch = border.vertical, .style = style};
+    const disp_span_t inner_cols = {first.x + 1, second.x - 1};
+    const disp_span_t inner_lines = {first.y + 1, second.y - 1};
+
+    if (first.x + 1 < second.x)
+    {
+        display_fill_row_span(display, horizontal, first.y, inner_cols);
+        display_fill_row_span(display, horizontal, second.y, inner_cols);
+    }
+    if (first.y + 1 < second.y)
     {
-        display_set_char(display, string[i], pos);
-        display_set_style(display, style, pos);
+        display_fill_col_span(display, vertical, first.x, inner_lines);
+        display_fill_col_span(display, vertical, second.x, inner_lines);
     }
+
+    // corners coincide on thin rectangles, ones drawn later win
+    set_border(display, border.bot_left, first.x, second.y, style);
+    set_border(display, border.bot_right, second.x, second.y, style);
+    set_border(display, border.top_right, second.x, first.y, style);
+    set_border(display, border.top_left, first.x, first.y, style);
+}
+
+void display_draw_string(display_t *const display, unsigned int size, const char string[size], disp_pos_t pos, style_t string_style)
+{
+    (void) display_draw_text(display, size, string, pos, UINT16_MAX, string_style, TEXT_TRUNCATE);
 }
 
 void display_draw_string_centered(display_t *const display, unsigned int size, const char string[size], disp_area_t area, style_t style)
 {
-    assert(area.second.x <= display->size.x);
-    assert(area.second.y <= display->size.y);
-    unsigned int hmax = area.second.x - area.first.x;
-    disp_pos_t pos = {.y = (area.first.y + area.second.y) / 2};
+    if (area.first.x > area.second.x || area.first.y > area.second.y) return;
+    const unsigned int hmax = area.second.x - area.first.x;
+    const unsigned int width = text_width(string, size);
+    disp_pos_t pos = {.x = area.first.x, .y = (area.first.y + area.second.y) / 2};
 
-    if (hmax <= size) // string doesnt fit fully in the area
+    if (hmax <= width) // string doesnt fit fully in the area
     {
-        pos.x = area.first.x;
-        size = hmax;
+        (void) display_draw_text(display, size, string, pos, hmax, style, TEXT_ELLIPSIZE);
+        return;
     }
-    else // calculate padding
+    pos.x += (hmax - width) / 2;
+    (void) display_draw_text(display, size, string, pos, width, style, TEXT_TRUNCATE);
+}
+
+unsigned int display_draw_text(display_t *const display, unsigned int size, const char string[size],
+        disp_pos_t pos, unsigned int width, style_t text_style, text_overflow_t overflow)
+{
+    // truncation happens while laying out, only ellipsis needs the fit upfront
+    bool ellipsis = false;
+    if (TEXT_ELLIPSIZE == overflow) size = text_fit(string, size, width, overflow, &ellipsis);
+
+    disp_area_t screen;
+    if (0 == width || !clip_to_screen(display, pos.x, pos.y, (long long) pos.x + width - 1, pos.y, &screen)) return 0;
+
+    const display_clip_t clip = current_clip(display);
+    const unsigned int skip = screen.first.x - (clip.x + pos.x);
+    const unsigned int columns = screen.second.x - screen.first.x + 1;
+    const style_id_t style = display_intern_style(display, text_style);
+
+    disp_char_t *const cells = display->scratch;
+    unsigned int laid = text_put(cells, skip, columns, string, size, style, &display->clusters);
+    if (ellipsis && laid < skip + columns)
+    {
+        char mark[UTF8_MAX];
+        const size_t length = utf8_encode(TEXT_ELLIPSIS, mark);
+        const unsigned int at = laid > skip ? laid - skip : 0;
+        laid += text_put(cells + at, skip > laid ? skip - laid : 0, columns - at, mark, length, style, &display->clusters);
+    }
+
+    if (laid > skip) copy_cells(display, screen.first.y, screen.first.x, cells, laid - skip);
+    return laid;
+}
+
+void display_blit(display_t *const display, const surface_t *const surface, disp_area_t src, disp_pos_t dst)
+{
+    disp_area_t to;
+    if (!surface_clip(surface, &src)) return;
+    if (!clip_to_screen(display, dst.x, dst.y,
+                (long long) dst.x + src.second.x - src.first.x,
+                (long long) dst.y + src.second.y - src.first.y, &to)) return;
+
+    // clipped off part of the destination skips the same part of the source
+    const display_clip_t clip = current_clip(display);
+    src.first.x += to.first.x - (clip.x + dst.x);
+    src.first.y += to.first.y - (clip.y + dst.y);
+
+    for (unsigned int line = to.first.y; line <= to.second.y; ++line)
     {
-        pos.x = area.first.x + (hmax - size) / 2;
+        const disp_char_t *const from = &surface_row(surface, src.first.y + line - to.first.y)[src.first.x];
+        copy_cells(display, line, to.first.x, from, to.second.x - to.first.x + 1);
     }
+}
 
-    display_draw_string(display, size, string, pos, style);
+static void set_border(display_t *const display, wchar_t border_char, unsigned int x, unsigned int y, style_id_t style)
+{
+    const disp_char_t cell = {.ch = border_char, .style = style};
+    display_fill_row_span(display, cell, y, (disp_span_t){x, x});
+}
+
+void display_deinit(display_t *const display)
+{
+    writer_stop(&display->writer);
+    // let the last frame out before the descriptor is gone
+    backend_set_blocking(&display->backend);
+    if (display->encoder.size)
+    {
+        (void) encoder_flush(&display->encoder, display_output_fd(display));
+    }
+    backend_close(&display->backend);
+    encoder_deinit(&display->encoder);
+    style_table_deinit(&display->styles);
+    cluster_table_deinit(&display->clusters);
+    pacer_deinit(&display->pacer);
+    if (display->has_resize_fd)
+    {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGWINCH);
+        sigprocmask(SIG_UNBLOCK, &mask, NULL);
+        close(display->resize_fd);
+        display->has_resize_fd = false;
+    }
+    for (int b = 0; b < DISP_BUFFERS; ++b)
+    {
+        free(display->buffers[b]);
+        display->buffers[b] = NULL;
+    }
+    free(display->dirty);
+    free(display->runs);
+    free(display->scratch);
+    free(display->hashes);
+    display->dirty = NULL;
+    display->runs = NULL;
+    display->scratch = NULL;
+    display->hashes = NULL;
+    display->size = (disp_pos_t){0};
 }
 
-static void set_border(display_t *const display, wchar_t border_char, disp_pos_t pos, style_t style)
+void display_resize(display_t *const display, disp_pos_t size)
 {
-    display_set_style(display, style, pos);
-    display_set_char(display, border_char, pos);
+    const size_t cells = (size_t) size.x * size.y;
+    const disp_char_t blank = {.ch = U' ', .style = STYLE_DEFAULT_ID};
+
+    for (int b = 0; b < DISP_BUFFERS; ++b)
+    {
+        disp_char_t *buffer = malloc((cells ? cells : 1) * sizeof(disp_char_t));
+        if (!buffer)
+        {
+            perror("display_resize");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < cells; ++i) buffer[i] = blank;
+
+        // keep what fits, so frame drawn before resize is not lost
+        if (display->buffers[b])
+        {
+            const unsigned int lines = size.y < display->size.y ? size.y : display->size.y;
+            const unsigned int cols = size.x < display->size.x ? size.x : display->size.x;
+            for (unsigned int line = 0; line < lines; ++line)
+            {
+                memcpy(&buffer[(size_t) line * size.x],
+                       row_at(display, b, line),
+                       cols * sizeof(disp_char_t));
+            }
+        }
+
+        free(display->buffers[b]);
+        display->buffers[b] = buffer;
+    }
+
+    disp_span_t *dirty = realloc(display->dirty, (size.y ? size.y : 1) * sizeof(disp_span_t));
+    if (!dirty)
+    {
+        perror("display_resize");
+        exit(EXIT_FAILURE);
+    }
+    for (unsigned int line = 0; line < size.y; ++line)
+    {
+        dirty[line] = (disp_span_t){0, size.x ? size.x - 1 : 0};
+    }
+    display->dirty = dirty;
+
+    disp_span_t *runs = realloc(display->runs, ROWDIFF_MAX_RUNS(size.x) * sizeof(disp_span_t));
+    if (!runs)
+    {
+        perror("display_resize");
+        exit(EXIT_FAILURE);
+    }
+    display->runs = runs;
+
+    disp_char_t *scratch = realloc(display->scratch, (size.x ? size.x : 1) * sizeof(disp_char_t));
+    if (!scratch)
+    {
+        perror("display_resize");
+        exit(EXIT_FAILURE);
+    }
+    display->scratch = scratch;
+
+    uint64_t *hashes = realloc(display->hashes, (size.y ? size.y : 1) * 2 * sizeof(uint64_t));
+    if (!hashes)
+    {
+        perror("display_resize");
+        exit(EXIT_FAILURE);
+    }
+    display->hashes = hashes;
+    if (!display->row_diff) display->row_diff = rowdiff_select();
+
+    display->size = size;
+    display->invalidated = true;
 }
 
-void display_erase(void)
+void display_erase(display_t *const display)
 {
-    printf(CLEAR);
+    // queued behind a frame still draining, the next render or deinit sends it
+    encoder_put_seq(&display->encoder, CLEAR, ENCODER_SEQ_ERASE);
+    display->reprint = true;
+    display->invalidated = true;
 }
 
 void display_clear(display_t *const display)
@@ -190,20 +641,7 @@ void display_clear(display_t *const display)
 
 void display_clear_area(display_t *const display, disp_area_t area)
 {
-    dispbuf_ptr_t active = display->buffers[display->active];
-
-    for (unsigned int line = area.first.y;
-            line <= area.second.y && line < display->size.y;
-            ++line)
-    {
-        for (unsigned int col = area.first.x;
-                col <= area.second.x && col < display->size.x;
-                ++col)
-        {
-            active[line][col].style = (style_t){ 0 };
-            active[line][col].ch = U' ';
-        }
-    }
+    display_fill_rect(display, BLANK_CELL, area);
 }
 
 
@@ -239,21 +677,329 @@ static int prev_buffer(const int active)
     return (active + DISP_BUFFERS - 1) % DISP_BUFFERS;
 }
 
-static bool disp_diff(const disp_char_t *const a, const disp_char_t *const b)
+static void scroll_screen(display_t *const display)
 {
-    return memcmp(a, b, sizeof(disp_char_t));
+    const unsigned int rows = display->size.y;
+    const unsigned int cols = display->size.x;
+
+    unsigned int dirty_rows = 0;
+    for (unsigned int line = 0; line < rows; ++line)
+    {
+        if (!IS_EMPTY_SPAN(&display->dirty[line])) ++dirty_rows;
+    }
+    // translation changes most of the rows at once
+    if (dirty_rows < SCROLL_MIN_GAIN || dirty_rows * 2 < rows) return;
+
+    const int prev = prev_buffer(display->active);
+    uint64_t *const now = display->hashes;
+    uint64_t *const before = display->hashes + rows;
+    for (unsigned int line = 0; line < rows; ++line)
+    {
+        now[line] = scroll_hash_row(row_at(display, display->active, line), cols);
+        before[line] = scroll_hash_row(row_at(display, prev, line), cols);
+    }
+
+    scroll_region_t region = scroll_detect(now, before, rows, rows / 2);
+    if (0 == region.lines)
+    {
+        shift_lines(display, now, before);
+        return;
+    }
+
+    encoder_scroll(&display->encoder, region.top, region.bottom, region.lines);
+    scroll_mirror(display, region);
 }
 
-static void display_swap_buffers(display_t *const display)
+/* Repeats the scroll on the buffer mirroring the screen */
+static void scroll_mirror(display_t *const display, scroll_region_t region)
 {
-    display->active = (display->active + 1) % DISP_BUFFERS;
+    const int prev = prev_buffer(display->active);
+    const disp_char_t blank = {.ch = U' ', .style = STYLE_DEFAULT_ID};
+    const unsigned int amount = region.lines > 0 ? region.lines : -region.lines;
+    const unsigned int kept = region.bottom - region.top + 1 - amount;
+    const unsigned int dst = region.lines > 0 ? region.top : region.top + amount;
+    const unsigned int src = region.lines > 0 ? region.top + amount : region.top;
+    const unsigned int exposed = region.lines > 0 ? region.bottom + 1 - amount : region.top;
+
+    memmove(row_at(display, prev, dst), row_at(display, prev, src),
+            (size_t) kept * display->size.x * sizeof(disp_char_t));
+
+    disp_char_t *cells = row_at(display, prev, exposed);
+    for (size_t i = 0; i < (size_t) amount * display->size.x; ++i) cells[i] = blank;
+
+    // rows are compared against the scrolled screen now
+    for (unsigned int line = region.top; line <= region.bottom; ++line)
+    {
+        display->dirty[line] = (disp_span_t){0, display->size.x - 1};
+    }
 }
 
-static disp_pos_t get_terminal_size(void)
+/* Shifts rows that moved sideways in place, only the exposed columns get repainted */
+static void shift_lines(display_t *const display, const uint64_t *const now, const uint64_t *const before)
 {
-    struct winsize w;
-    ioctl(0, TIOCGWINSZ, &w);
-    return (disp_pos_t){w.ws_col, w.ws_row};
+    const unsigned int rows = display->size.y;
+    const unsigned int cols = display->size.x;
+    const int prev = prev_buffer(display->active);
+    const int max_shift = cols / 2 < SCROLL_MAX_COLS ? cols / 2 : SCROLL_MAX_COLS;
+
+    int best_shift = 0;
+    unsigned int best_rows = SCROLL_MIN_GAIN - 1;
+    for (int shift = -max_shift; shift <= max_shift; ++shift)
+    {
+        if (0 == shift) continue;
+
+        unsigned int shifted = 0;
+        for (unsigned int line = 0; line < rows; ++line)
+        {
+            if (now[line] != before[line]
+                && is_line_shifted(row_at(display, display->active, line),
+                                   row_at(display, prev, line), cols, shift))
+            {
+                ++shifted;
+            }
+        }
+        if (shifted > best_rows)
+        {
+            best_rows = shifted;
+            best_shift = shift;
+        }
+    }
+    if (0 == best_shift) return;
+
+    const disp_char_t blank = {.ch = U' ', .style = STYLE_DEFAULT_ID};
+    const unsigned int amount = best_shift > 0 ? best_shift : -best_shift;
+    for (unsigned int line = 0; line < rows; ++line)
+    {
+        disp_char_t *const mirror = row_at(display, prev, line);
+        if (now[line] == before[line]
+            || !is_line_shifted(row_at(display, display->active, line), mirror, cols, best_shift))
+        {
+            continue;
+        }
+
+        encoder_shift_line(&display->encoder, line, best_shift);
+        if (best_shift > 0)
+        {
+            memmove(mirror, mirror + amount, (cols - amount) * sizeof(disp_char_t));
+            for (unsigned int col = cols - amount; col < cols; ++col) mirror[col] = blank;
+        }
+        else
+        {
+            memmove(mirror + amount, mirror, (cols - amount) * sizeof(disp_char_t));
+            for (unsigned int col = 0; col < amount; ++col) mirror[col] = blank;
+        }
+        display->dirty[line] = (disp_span_t){0, cols - 1};
+    }
+}
+
+/* Whether `now` is `before` moved by `shift` columns, positive is left */
+static bool is_line_shifted(const disp_char_t *const now, const disp_char_t *const before, unsigned int cols, int shift)
+{
+    if (shift > 0) return 0 == memcmp(now, before + shift, (cols - shift) * sizeof(disp_char_t));
+    return 0 == memcmp(now - shift, before, (cols + shift) * sizeof(disp_char_t));
+}
+
+/* Sends encoded frame to the writer thread or straight to the terminal */
+static int present(display_t *const display)
+{
+    if (display->writer.running)
+    {
+        // notifications coalesce, the frame written before has to be reported first
+        collect_written(display);
+        return writer_submit(&display->writer, &display->encoder, display->encoded_frame);
+    }
+
+    const uint64_t start = clock_now_ns();
+    const int status = encoder_flush(&display->encoder, display_output_fd(display));
+    if (status && EAGAIN != status)
+    {
+        // mirror holds the lost frame, the terminal does not
+        display->reprint = true;
+        display->invalidated = true;
+    }
+    else if (0 == status)
+    {
+        display->encoder.stats.write_ns = clock_now_ns() - start;
+        stats_set(&display->stats, display->encoded_frame, STAT_WRITE_NS, display->encoder.stats.write_ns);
+    }
+    return status;
+}
+
+/* Records write time of the frame the writer thread finished, reprints when it was lost */
+static void collect_written(display_t *const display)
+{
+    size_t frame;
+    uint64_t write_ns;
+    bool lost;
+    if (!writer_collect(&display->writer, &frame, &write_ns, &lost)) return;
+
+    if (lost)
+    {
+        // mirror holds the lost frame, the terminal does not
+        display->reprint = true;
+        display->invalidated = true;
+        return;
+    }
+    display->encoder.stats.write_ns = write_ns;
+    stats_set(&display->stats, frame, STAT_WRITE_NS, write_ns);
+}
+
+/* Completes counters of the encoded frame, its write time is set once it is out */
+static void record_frame(display_t *const display)
+{
+    frame_stats_t *const frame = &display->frame;
+    const encoder_t *const encoder = &display->encoder;
+
+    frame->values[STAT_BYTES] = encoder->size;
+    frame->values[STAT_ENCODE_NS] = encoder->stats.encode_ns;
+    for (int kind = 0; kind < ENCODER_SEQ_KINDS; ++kind)
+    {
+        frame->sequences[kind] = encoder->sequences[kind];
+        frame->values[STAT_SEQUENCES] += encoder->sequences[kind];
+    }
+    display->encoded_frame = stats_record(&display->stats, frame);
+}
+
+
+static disp_char_t *row_at(const display_t *const display, int buffer, unsigned int line)
+{
+    return &display->buffers[buffer][(size_t) line * display->size.x];
+}
+
+/* Innermost clip, whole screen when none is pushed */
+static display_clip_t current_clip(const display_t *const display)
+{
+    if (display->clip_depth) return display->clips[display->clip_depth - 1];
+    return (display_clip_t){
+        .area = {{0, 0}, {display->size.x - 1, display->size.y - 1}},
+        .empty = 0 == display->size.x || 0 == display->size.y,
+    };
 }
 
+/* Translates area given in drawing coordinates to the screen and cuts it by the clip */
+static bool clip_to_screen(const display_t *const display,
+        long long x1, long long y1, long long x2, long long y2, disp_area_t *const area)
+{
+    const display_clip_t clip = current_clip(display);
+    if (clip.empty) return false;
+
+    x1 += clip.x; x2 += clip.x;
+    y1 += clip.y; y2 += clip.y;
+    if (x1 < clip.area.first.x) x1 = clip.area.first.x;
+    if (y1 < clip.area.first.y) y1 = clip.area.first.y;
+    if (x2 > clip.area.second.x) x2 = clip.area.second.x;
+    if (y2 > clip.area.second.y) y2 = clip.area.second.y;
+    if (x1 > x2 || y1 > y2) return false;
+
+    *area = (disp_area_t){{x1, y1}, {x2, y2}};
+    return true;
+}
+
+/* Sets cells `first..last` of the screen line, they must be inside of it */
+static void write_row(display_t *const display, disp_char_t cell, unsigned int line, unsigned int first, unsigned int last)
+{
+    // trim cells which already hold the value, dirty span covers only changes
+    disp_char_t *const row = row_at(display, display->active, line);
+    ++last;
+    while (first < last && same_cell(&row[first], &cell)) ++first;
+    if (first == last) return;
+    while (same_cell(&row[last - 1], &cell)) --last;
+
+    // plain loop of 8 byte stores, compiler turns it into vector stores
+    for (unsigned int col = first; col < last; ++col) row[col] = cell;
+    display_mark_dirty(display, line, first);
+    display_mark_dirty(display, line, last - 1);
+    seal(display, line, first);
+    seal(display, line, last);
+}
+
+/* Copies cells to the screen line at `x`, they must fit into it */
+static void copy_cells(display_t *const display, unsigned int line, unsigned int x, const disp_char_t *const cells, unsigned int count)
+{
+    // narrow the copy to changed cells, dirty span stays tight
+    disp_char_t *const row = &row_at(display, display->active, line)[x];
+    unsigned int first = 0, last = count;
+    while (first < last && same_cell(&row[first], &cells[first])) ++first;
+    if (first == last) return;
+    while (same_cell(&row[last - 1], &cells[last - 1])) --last;
+
+    memcpy(&row[first], &cells[first], (last - first) * sizeof(disp_char_t));
+    display_mark_dirty(display, line, x + first);
+    display_mark_dirty(display, line, x + last - 1);
+    seal(display, line, x + first);
+    seal(display, line, x + last);
+}
 
+static bool same_cell(const disp_char_t *const a, const disp_char_t *const b)
+{
+    return 0 == memcmp(a, b, sizeof(disp_char_t));
+}
+
+/* Slow path of `display_set_char`: glyph is not narrow or the cell is not */
+static void set_glyph(display_t *const display, uint32_t ch, unsigned int width, disp_pos_t pos)
+{
+    disp_char_t *const row = row_at(display, display->active, pos.y);
+    if (0 == width && (ch < 0x20 || (ch >= 0x7f && ch < 0xa0)))
+    {
+        ch = U' '; // controls would move the cursor
+        width = 1;
+    }
+    if (0 == width)
+    {
+        // combining mark joins the glyph the cell belongs to
+        if ((row[pos.x].flags & CELL_CONTINUATION) && pos.x > 0) --pos.x;
+        text_combine(&row[pos.x], ch, &display->clusters);
+        display_mark_dirty(display, pos.y, pos.x);
+        return;
+    }
+    if (2 == width && pos.x + 1u > current_clip(display).area.second.x)
+    {
+        ch = U' '; // right half would be outside of the clip
+        width = 1;
+    }
+
+    row[pos.x] = (disp_char_t){.ch = ch, .style = row[pos.x].style, .flags = 2 == width ? CELL_WIDE : 0};
+    if (2 == width) row[pos.x + 1] = (disp_char_t){.ch = 0, .style = row[pos.x].style, .flags = CELL_CONTINUATION};
+    display_mark_dirty(display, pos.y, pos.x);
+    display_mark_dirty(display, pos.y, pos.x + width - 1);
+    seal(display, pos.y, pos.x);
+    seal(display, pos.y, pos.x + width);
+}
+
+/* Blanks half of a wide glyph which a write at column `x` separated from the other half */
+static void seal(display_t *const display, unsigned int line, unsigned int x)
+{
+    disp_char_t *const row = row_at(display, display->active, line);
+    const bool wide = x > 0 && (row[x - 1].flags & CELL_WIDE);
+    const bool continuation = x < display->size.x && (row[x].flags & CELL_CONTINUATION);
+    if (wide == continuation) return;
+
+    const unsigned int col = wide ? x - 1 : x;
+    row[col] = (disp_char_t){.ch = U' ', .style = row[col].style};
+    display_mark_dirty(display, line, col);
+}
+
+/* Prints glyph of the flagged cell, returns columns it took */
+static unsigned int put_cell(display_t *const display, const disp_char_t *const row, unsigned int col)
+{
+    encoder_t *const encoder = &display->encoder;
+    const disp_char_t cell = row[col];
+    const bool whole = (cell.flags & CELL_WIDE) && col + 1u < display->size.x
+        && (row[col + 1].flags & CELL_CONTINUATION);
+
+    // lone half of a wide glyph shows as blank
+    if ((cell.flags & (CELL_WIDE | CELL_CONTINUATION)) && !whole)
+    {
+        encoder_put_char(encoder, U' ');
+        return 1;
+    }
+
+    const unsigned int width = whole ? 2 : 1;
+    if (cell.flags & CELL_CLUSTER)
+    {
+        encoder_put_cluster(encoder, cluster_table_get(&display->clusters, cell.ch), width);
+    }
+    else if (whole) encoder_put_wide_char(encoder, cell.ch);
+    else encoder_put_char(encoder, cell.ch);
+    return width;
+}
@@ -2,14 +2,22 @@
 #define _DISPLAY_H_
 
 #include "display_types.h"
+#include "backend.h"
 #include "border.h"
+#include "encoder.h"
+#include "pacer.h"
+#include "rowdiff.h"
+#include "scroll.h"
+#include "stats.h"
+#include "style.h"
+#include "surface.h"
+#include "text.h"
+#include "writer.h"
 #include <wchar.h>
 
 #include <stdbool.h>
 
 #define DISP_BUFFERS 2
-#define DISP_MAX_WIDTH 256
-#define DISP_MAX_HEIGHT 256
 
 #define ESC         "\x1b"
 #define HOME        ESC "[H"
@@ -20,27 +28,19 @@
 #define SHOW_CURSOR ESC "[?25h"
 #define ERASE_LINE  ESC "[K"
 
-typedef struct
-{
-    const char *seq;
-}
-style_t;
+#define DISPLAY_MAX_CLIPS 16
 
+/* Bounds of drawing, see `display_push_clip` */
 typedef struct
 {
-    style_t style;
-    wchar_t ch;
+    int32_t     x;     /* where drawing coordinates start on the screen */
+    int32_t     y;
+    disp_area_t area;  /* part of the screen drawing may touch          */
+    bool        empty; /* nothing is visible                            */
 }
-disp_char_t;
-typedef disp_char_t (*dispbuf_ptr_t)[DISP_MAX_WIDTH];
+display_clip_t;
 
-typedef struct display
-{
-    disp_char_t buffers[DISP_BUFFERS][DISP_MAX_HEIGHT][DISP_MAX_WIDTH];
-    int active; /* index of the active buffer */
-    disp_pos_t size;
-}
-display_t;
+typedef struct display display_t;
 
 typedef struct
 {
@@ -49,15 +49,120 @@ typedef struct
 }
 resize_hook_with_data_t;
 
+struct display
+{
+    /* `size.y` contiguous rows of `size.x` cells each */
+    disp_char_t *buffers[DISP_BUFFERS];
+    int active; /* index of the buffer being drawn, other one mirrors the screen */
+    disp_pos_t size;
+    disp_span_t *dirty; /* per row: columns changed in active buffer since render */
+    disp_span_t *runs;  /* scratch for changed runs of a row */
+    disp_char_t *scratch; /* row of cells laid out before copying to the screen */
+    uint64_t *hashes;   /* scratch for row hashes of both buffers */
+    rowdiff_t row_diff; /* kernel selected for the running cpu */
+    bool invalidated;   /* content changed, frame has to be rendered */
+    bool reprint;       /* screen content is unknown, every cell has to be printed */
+    backend_t backend;  /* where frames go and screen size comes from */
+    int resize_fd;      /* signalfd delivering SIGWINCH */
+    bool has_resize_fd;
+    resize_hook_with_data_t resize_hook;
+    pacer_t pacer;      /* limits frames per second */
+    style_table_t styles; /* interned styles referenced by cells */
+    cluster_table_t clusters; /* glyphs with combining marks referenced by cells */
+    encoder_t encoder; /* accumulates output of the frame */
+    writer_t writer;   /* optional thread writing frames out */
+    display_clip_t clips[DISPLAY_MAX_CLIPS]; /* drawing bounds, last one applies */
+    size_t clip_depth;
+    size_t clip_overflow; /* pushes beyond the stack, they show nothing */
+    frame_stats_t frame; /* counters of the frame being rendered */
+    stats_t stats;       /* counters of the recent frames */
+    size_t encoded_frame; /* number of the frame in the encoder, in `stats` */
+};
+
 
+style_id_t
+display_intern_style(display_t *const display,
+        style_t style);
+/* Slow path of `display_set_char`: wide glyphs, combining marks and cells they cover */
 void
-display_set_char(display_t *const display,
+display_set_glyph(display_t *const display,
         wint_t ch,
         disp_pos_t pos);
-void 
+
+/*
+ * Cell accessors are called for every cell drawn, they live here
+ * so callers in other translation units inline them.
+ */
+
+/* Translates `pos` to the screen, returns its cell or NULL when it is clipped out */
+static inline disp_char_t *
+display_visible_cell(const display_t *const display,
+        disp_pos_t *const pos)
+{
+    long long x = pos->x, y = pos->y;
+    if (display->clip_depth)
+    {
+        const display_clip_t *const clip = &display->clips[display->clip_depth - 1];
+        x += clip->x;
+        y += clip->y;
+        if (clip->empty
+            || x < clip->area.first.x || x > clip->area.second.x
+            || y < clip->area.first.y || y > clip->area.second.y) return NULL;
+    }
+    else if (x >= display->size.x || y >= display->size.y) return NULL;
+
+    *pos = (disp_pos_t){x, y};
+    return &display->buffers[display->active][(size_t) pos->y * display->size.x + pos->x];
+}
+
+/* Widens the dirty span of the screen line to `col` */
+static inline void
+display_mark_dirty(display_t *const display,
+        unsigned int line,
+        unsigned int col)
+{
+    disp_span_t *const dirty = &display->dirty[line];
+    if (col < dirty->first) dirty->first = col;
+    if (col > dirty->last) dirty->last = col;
+}
+
+static inline void
+display_set_char(display_t *const display,
+        wint_t ch,
+        disp_pos_t pos)
+{
+    disp_pos_t screen = pos;
+    disp_char_t *const cell = display_visible_cell(display, &screen);
+    if (!cell) return;
+    if (1 != glyph_width(ch) || cell->flags) // keeps wide glyphs whole
+    {
+        display_set_glyph(display, ch, pos);
+        return;
+    }
+    if (cell->ch == (uint32_t) ch) return;
+    cell->ch = ch;
+    display_mark_dirty(display, screen.y, screen.x);
+}
+
+static inline void
+display_set_style_id(display_t *const display,
+        style_id_t style,
+        disp_pos_t pos)
+{
+    disp_char_t *const cell = display_visible_cell(display, &pos);
+    if (!cell || cell->style == style) return;
+    cell->style = style;
+    display_mark_dirty(display, pos.y, pos.x);
+}
+
+static inline void
 display_set_style(display_t *const display,
         style_t style,
-        disp_pos_t pos);
+        disp_pos_t pos)
+{
+    display_set_style_id(display, display_intern_style(display, style), pos);
+}
+
 void
 display_draw_border(display_t *const display,
         style_t style,
@@ -67,6 +172,44 @@ void
 display_fill_area(display_t *const display,
         style_t style,
         disp_area_t area);
+/*
+ * Restricts drawing to `rect` and moves origin of drawing coordinates to its corner.
+ * Rect is given in the current drawing coordinates and is cut by the current clip.
+ * Returns false when nothing of it is visible, so drawing may be skipped.
+ * Every push needs its `display_pop_clip`.
+ */
+bool
+display_push_clip(display_t *const display,
+        disp_rect_t rect);
+void display_pop_clip(display_t *const display);
+
+/*
+ * Drawing functions below take coordinates relative to the current clip
+ * and touch only cells inside of it.
+ */
+
+/* Sets cells of the span on the row, only those which change are marked dirty */
+void
+display_fill_row_span(display_t *const display,
+        disp_char_t cell,
+        unsigned int line,
+        disp_span_t span);
+/* Sets cells of the `col` on lines of the span */
+void
+display_fill_col_span(display_t *const display,
+        disp_char_t cell,
+        unsigned int col,
+        disp_span_t span);
+void
+display_fill_rect(display_t *const display,
+        disp_char_t cell,
+        disp_area_t area);
+/* Outline of the rectangle, costs its perimeter and leaves inside untouched */
+void
+display_draw_rect(display_t *const display,
+        style_id_t style,
+        border_set_t border,
+        disp_area_t area);
 void
 display_draw_string(display_t *const display,
         unsigned int size,
@@ -79,9 +222,32 @@ display_draw_string_centered(display_t *const display,
         const char string[size],
         disp_area_t area,
         style_t style);
+/*
+ * Draws UTF-8 `string` into at most `width` columns from `pos`, wide glyphs take two.
+ * With TEXT_ELLIPSIZE a string too wide ends in an ellipsis.
+ * Returns columns the text spans, clipped part included.
+ */
+unsigned int
+display_draw_text(display_t *const display,
+        unsigned int size,
+        const char string[size],
+        disp_pos_t pos,
+        unsigned int width,
+        style_t style,
+        text_overflow_t overflow);
+/*
+ * Copies `src` area of the surface to `dst` row by row, clipped to both.
+ * Only cells that differ are marked dirty, so blitting unchanged content is cheap.
+ */
+void
+display_blit(display_t *const display,
+        const surface_t *const surface,
+        disp_area_t src,
+        disp_pos_t dst);
 void
 display_render(display_t *const display);
 
+/* Encodes changes within the area, output is sent by `display_render` */
 void
 display_render_area(display_t *const display,
         disp_area_t area);
@@ -89,13 +255,96 @@ void
 display_clear_area(display_t *const display,
         disp_area_t area);
 
+/* Picks up terminal size and starts watching for resizes through `display_resize_fd` */
 void 
 display_set_resize_handler(display_t *const display,
                            resize_hook_with_data_t resize_hook);
 
+/*
+ * Reopens the terminal for output in non-blocking mode, so rendering never waits
+ * for a slow terminal. Frames requested while the previous one is still being
+ * written are merged into the next one. stdin is not affected.
+ * Returns 0 or errno, frames are written to blocking stdout on failure.
+ */
+int display_open_output(display_t *const display);
+
+/* Renders into another backend, display takes ownership and is resized to it */
+void
+display_set_backend(display_t *const display,
+        backend_t backend);
+
+/* Descriptor to watch for EPOLLOUT, edge triggered */
+int display_output_fd(const display_t *const display);
+
+/*
+ * Moves writing of frames to a separate thread, next frame is encoded
+ * while the previous one is being written. Returns 0 or errno.
+ */
+int display_start_writer(display_t *const display);
+
+/* Descriptor to watch for EPOLLIN when writer thread is running, otherwise -1 */
+int display_writer_fd(const display_t *const display);
+
+/* Sends the rest of the pending frame, call it when output is writable or writer is done */
+void display_on_output_ready(display_t *const display);
+
+/* Descriptor to watch for terminal resizes, -1 when resizes are not watched */
+int display_resize_fd(const display_t *const display);
+
+/* Consumes pending resize signals, resizes the display once and calls the resize hook */
+void display_on_resize_signal(display_t *const display);
+
+/* Reallocates buffers to the new size, keeping the overlapping content */
+void
+display_resize(display_t *const display,
+        disp_pos_t size);
+
+/* Schedules a render: input, data update, timer... */
+void display_invalidate(display_t *const display);
+
+/* Whether something requested a render and the terminal can take it */
+bool display_needs_render(const display_t *const display);
+
+/* Caps presents per second, 0 means unlimited. Returns 0 or errno */
+int display_set_max_fps(display_t *const display, unsigned int max_fps);
+
+/*
+ * Whether the pending frame fits into the frame rate limit now,
+ * otherwise the frame timer will wake the loop up when it does.
+ */
+bool display_frame_due(display_t *const display);
+
+/* Descriptor to watch for the frame timer, -1 when frame rate is not limited */
+int display_frame_timer_fd(const display_t *const display);
+void display_on_frame_timer(display_t *const display);
+
+/* Frames that were presented after their slot has passed */
+size_t display_missed_deadlines(const display_t *const display);
+
+/* Counters of the frame rendered `age` frames ago, NULL when it is forgotten */
+const frame_stats_t *
+display_frame_stats(const display_t *const display,
+        size_t age);
+
+/* Distribution of `metric` over the last STATS_WINDOW frames */
+stats_histogram_t
+display_stats_histogram(const display_t *const display,
+        stat_metric_t metric);
+
+/*
+ * Detects optional terminal features, call once terminal is in raw mode.
+ * Without detection frames are sent as plain output.
+ * Input typed meanwhile is returned in `typed`, to be given to the input.
+ */
+void
+display_query_caps(display_t *const display,
+        termcaps_typed_t *const typed);
+
+void display_deinit(display_t *const display);
 void display_clear(display_t *const display);
 bool disp_pos_equal(disp_pos_t a, disp_pos_t b);
 disp_area_t normalized_area(disp_area_t area);
-void display_erase(void);
+/* Clears the terminal through the backend, goes out with the next frame or on deinit */
+void display_erase(display_t *const display);
 
 #endif//_DISPLAY_H_
@@ -1,33 +1,227 @@
 #include "display.h"
-#include "input.h"
-#include <termio.h>
+
+#include <assert.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
-void resize_hook(const display_t *const display, void *data)
+#define COLS 200
+#define ROWS 60
+#define FRAMES 500
+
+typedef struct
 {
-    (void) display;
-    (void) data;
+    const char *name;
+    void (*draw)(display_t *const display, unsigned int frame);
 }
+workload_t;
 
-int main(void)
+static double now(void)
 {
-    resize_hook_with_data_t hook = {.hook = resize_hook};
-    display_t display;
-    input_enable_mouse();
-    display_set_resize_handler(&display, hook);
-    while (1)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* every cell changes every frame, not as a translation scrolling could catch */
+static void draw_full(display_t *const display, unsigned int frame)
+{
+    for (unsigned int y = 0; y < display->size.y; ++y)
     {
-        display_clear(&display);
-        for (unsigned int i = 0; i < display.size.y; ++i)
+        for (unsigned int x = 0; x < display->size.x; ++x)
         {
-            for (unsigned int j = 0; j < display.size.x; ++j)
-            {
-                display_set_char(&display, U'=', (disp_pos_t){j, i});
-            }
+            display_set_char(display, U'a' + (x * x + 3 * y * y + x * y + frame) % 26, (disp_pos_t){x, y});
         }
-        usleep(100);
+    }
+}
+
+/* static panels, only a counter changes */
+static void draw_panels(display_t *const display, unsigned int frame)
+{
+    border_set_t border = {._ = L"╭╮╯╰│─"};
+    display_clear(display);
+    display_draw_border(display, BORDER_STYLE_1, border,
+            (disp_area_t){{0, 0}, {display->size.x / 2 - 1, display->size.y - 1}});
+    display_draw_border(display, BORDER_STYLE_2, border,
+            (disp_area_t){{display->size.x / 2, 0}, {display->size.x - 1, display->size.y - 1}});
+
+    char counter[32];
+    int length = snprintf(counter, sizeof(counter), "frame %u", frame);
+    display_draw_string(display, length, counter, (disp_pos_t){2, 1}, BORDER_STYLE_4);
+}
+
+/* log view: every line is new text, mostly ASCII with some UTF-8 */
+static void draw_log(display_t *const display, unsigned int frame)
+{
+    char line[COLS * 2];
+    for (unsigned int y = 0; y < display->size.y; ++y)
+    {
+        const unsigned int number = frame * display->size.y + y;
+        int length = snprintf(line, sizeof(line), "%8u %s request served in %u.%03ums from 10.0.%u.%u, path /api/v1/items/%u?page=%u",
+                number, number % 16 ? "INFO" : "警告", number % 97, number % 1000, number % 256, number % 7, number, y);
+        display_draw_text(display, length, line, (disp_pos_t){0, y}, display->size.x, (style_t){0}, TEXT_ELLIPSIZE);
+    }
+}
+
+/* reads everything rendered so far, so pty never blocks the display */
+static size_t drain(display_t *const display)
+{
+    static char sink[64 * 1024];
+    size_t total = 0;
+    ssize_t bytes;
+    do
+    {
+        while ((bytes = backend_read(&display->backend, sink, sizeof(sink))) > 0)
+        {
+            total += bytes;
+        }
+        display_on_output_ready(display);
+    }
+    while (display->encoder.draining);
+    return total;
+}
+
+/* no write leaves half of a wide glyph behind, vertical spans included */
+static void check_wide_halves(void)
+{
+    display_t display = {0};
+    display_resize(&display, (disp_pos_t){COLS, ROWS});
+    static const char text[] = "世界世界世界世界世界";
+    for (unsigned int y = 0; y < 4; ++y)
+    {
+        display_draw_text(&display, sizeof(text) - 1, text, (disp_pos_t){0, y}, COLS, (style_t){0}, TEXT_TRUNCATE);
+    }
+    const disp_char_t bar = {.ch = U'│'};
+    display_fill_col_span(&display, bar, 3, (disp_span_t){0, 1}); // over right halves
+    display_fill_col_span(&display, bar, 4, (disp_span_t){2, 3}); // over left halves
+
+    for (unsigned int y = 0; y < 4; ++y)
+    {
+        const disp_char_t *const row = &display.buffers[display.active][y * COLS];
+        for (unsigned int x = 0; x < COLS; ++x)
+        {
+            const bool wide = row[x].flags & CELL_WIDE;
+            const bool continued = x + 1 < COLS && (row[x + 1].flags & CELL_CONTINUATION);
+            assert(wide == continued);
+        }
+    }
+    assert(U' ' == display.buffers[display.active][2].ch);
+    assert(U' ' == display.buffers[display.active][2 * COLS + 5].ch);
+    display_deinit(&display);
+}
+
+/* changes made while output is busy are merged and counted once per frame */
+static void check_merged_frames(void)
+{
+    backend_t backend;
+    if (backend_open_pty(&backend, (disp_pos_t){COLS, ROWS})) return;
+    display_t display = {0};
+    display_set_backend(&display, backend);
+
+    // nobody reads the pty, it fills up
+    for (unsigned int frame = 0; !display.encoder.draining; ++frame)
+    {
+        draw_full(&display, frame);
+        display_render(&display);
+    }
+    assert(!display_needs_render(&display));
+    display_invalidate(&display);
+    display_invalidate(&display);
+    assert(1 == display.encoder.stats.dropped);
+
+    drain(&display);
+    assert(display_needs_render(&display));
+    display_render(&display);
+    drain(&display);
+    assert(!display_needs_render(&display) && 1 == display.encoder.stats.dropped);
+    display_deinit(&display);
+}
+
+static void wait_writer(display_t *const display)
+{
+    while (atomic_load(&display->writer.busy)) sched_yield();
+}
+
+/* write times land on the frames written even when notifications coalesce, lost frames get reprinted */
+static void check_writer_frames(void)
+{
+    backend_t backend;
+    if (backend_open_memory(&backend, (disp_pos_t){COLS, ROWS})) return;
+    display_t display = {0};
+    display_set_backend(&display, backend);
+    if (display_start_writer(&display))
+    {
+        display_deinit(&display);
+        return;
+    }
+
+    draw_full(&display, 0);
+    display_render(&display);
+    wait_writer(&display);
+    draw_full(&display, 1);
+    display_render(&display);
+    wait_writer(&display);
+    display_on_output_ready(&display);
+    assert(display_frame_stats(&display, 0)->values[STAT_WRITE_NS] > 0);
+    assert(display_frame_stats(&display, 1)->values[STAT_WRITE_NS] > 0);
+
+    // output that can not be written to
+    const int readonly = open("/dev/null", O_RDONLY);
+    dup2(readonly, display_output_fd(&display));
+    close(readonly);
+    draw_full(&display, 2);
+    display_render(&display);
+    wait_writer(&display);
+    display_on_output_ready(&display);
+    assert(display.reprint && display_needs_render(&display));
+    display_deinit(&display);
+}
+
+static void bench(const char *const name, backend_t backend, const workload_t *const workload)
+{
+    display_t display = {0};
+    display_set_backend(&display, backend);
+    assert(display.size.x == COLS && display.size.y == ROWS);
+
+    size_t bytes = 0;
+    double start = now();
+    for (unsigned int frame = 0; frame < FRAMES; ++frame)
+    {
+        workload->draw(&display, frame);
         display_render(&display);
+        bytes += drain(&display);
+    }
+    double elapsed = now() - start;
+
+    const stats_histogram_t encode = display_stats_histogram(&display, STAT_ENCODE_NS);
+    printf("  %-6s %-7s %8.1f frames/s %8.2f MB/s %6zu bytes/frame, encode p50 %6luns p99 %6luns (%zu dropped)\n",
+            name, workload->name, FRAMES / elapsed, bytes / elapsed / 1e6,
+            bytes / FRAMES, (unsigned long) encode.p50, (unsigned long) encode.p99,
+            display.encoder.stats.dropped);
+    display_deinit(&display);
+}
+
+int main(void)
+{
+    const disp_pos_t size = {COLS, ROWS};
+    const workload_t workloads[] = {
+        {"full",   draw_full},
+        {"panels", draw_panels},
+        {"log",    draw_log},
+    };
+
+    check_wide_halves();
+    check_merged_frames();
+    check_writer_frames();
+
+    printf("%ux%u, %u frames:\n", COLS, ROWS, FRAMES);
+    for (size_t w = 0; w < sizeof(workloads) / sizeof(*workloads); ++w)
+    {
+        backend_t backend;
+        if (0 == backend_open_memory(&backend, size)) bench("memory", backend, &workloads[w]);
+        if (0 == backend_open_pty(&backend, size)) bench("pty", backend, &workloads[w]);
     }
-    input_disable_mouse();
     return 0;
 }
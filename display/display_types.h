@@ -19,6 +19,27 @@ typedef struct
 }
 disp_area_t;
 
+/* Rectangle which may lie partly or fully outside of the screen */
+typedef struct
+{
+    int32_t  x;
+    int32_t  y;
+    uint32_t width;
+    uint32_t height;
+}
+disp_rect_t;
+
+/* Range of columns on a row, empty when first > last */
+typedef struct
+{
+    uint16_t first;
+    uint16_t last;
+}
+disp_span_t;
+
+#define EMPTY_SPAN ((disp_span_t) {.first = UINT16_MAX, .last = 0})
+#define IS_EMPTY_SPAN(span_ptr) ((span_ptr)->first > (span_ptr)->last)
+
 #define IS_INVALID_AREA(area_ptr) \
    ((area_ptr)->first.x  == (uint16_t) -1 &&\
     (area_ptr)->first.y  == (uint16_t) -1 &&\
@@ -0,0 +1,428 @@
+#include "encoder.h"
+#include "utf8.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#define ESC "\x1b"
+
+typedef enum { VERT_NONE, VERT_ABSOLUTE, VERT_UP, VERT_DOWN, VERT_NEWLINE } vert_move_t;
+typedef enum { HORZ_NONE, HORZ_FORWARD, HORZ_BACK, HORZ_RETURN } horz_move_t;
+
+static void reserve(encoder_t *const encoder, size_t amount);
+static void advance(encoder_t *const encoder, unsigned int cols);
+static void put_glyph(encoder_t *const encoder, wchar_t ch);
+static unsigned int digits(unsigned int value);
+static unsigned int csi_cost(unsigned int n);
+static unsigned int horz_cost(unsigned int from, unsigned int to, horz_move_t *move);
+static void put_csi(encoder_t *const encoder, unsigned int n, char final, encoder_seq_t kind);
+static void put_cup(encoder_t *const encoder, disp_pos_t pos);
+static void put_repeated(encoder_t *const encoder, char ch, unsigned int times);
+
+void encoder_deinit(encoder_t *const encoder)
+{
+    free(encoder->data);
+    *encoder = (encoder_t){0};
+}
+
+void encoder_begin_frame(encoder_t *const encoder, disp_pos_t screen)
+{
+    encoder->screen = screen;
+    encoder->cursor_valid = false;
+    encoder->wrap_pending = false;
+    memset(encoder->sequences, 0, sizeof(encoder->sequences));
+}
+
+void encoder_end_frame(encoder_t *const encoder)
+{
+    encoder_set_style(encoder, &(sgr_state_t){0});
+}
+
+void encoder_put(encoder_t *const encoder, const char *const bytes, size_t size)
+{
+    reserve(encoder, size);
+    memcpy(encoder->data + encoder->size, bytes, size);
+    encoder->size += size;
+}
+
+void encoder_puts(encoder_t *const encoder, const char *const string)
+{
+    encoder_put(encoder, string, strlen(string));
+}
+
+void encoder_put_seq(encoder_t *const encoder, const char *const sequence, encoder_seq_t kind)
+{
+    encoder_puts(encoder, sequence);
+    ++encoder->sequences[kind];
+}
+
+void encoder_put_uint(encoder_t *const encoder, unsigned int value)
+{
+    char digits[sizeof(unsigned int) * CHAR_BIT / 3 + 1];
+    size_t i = sizeof(digits);
+    do
+    {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    }
+    while (value);
+
+    encoder_put(encoder, digits + i, sizeof(digits) - i);
+}
+
+void encoder_put_char(encoder_t *const encoder, wchar_t ch)
+{
+    put_glyph(encoder, ch);
+    advance(encoder, 1);
+}
+
+void encoder_put_wide_char(encoder_t *const encoder, wchar_t ch)
+{
+    put_glyph(encoder, ch);
+    advance(encoder, 2);
+}
+
+void encoder_put_cluster(encoder_t *const encoder, const cluster_t *const cluster, unsigned int width)
+{
+    put_glyph(encoder, cluster->base);
+    for (uint32_t i = 0; i < cluster->count; ++i) put_glyph(encoder, cluster->marks[i]);
+    advance(encoder, width);
+}
+
+void encoder_put_char_repeated(encoder_t *const encoder, wchar_t ch, unsigned int count)
+{
+    if (0 == count) return;
+
+    const size_t before = encoder->size;
+    encoder_put_char(encoder, ch);
+    const size_t bytes = encoder->size - before;
+    if (1 == count) return;
+
+    // REP must directly follow the character it repeats
+    if (encoder->caps.rep && csi_cost(count - 1) < (count - 1) * bytes)
+    {
+        put_csi(encoder, count - 1, 'b', ENCODER_SEQ_REPEAT);
+        advance(encoder, count - 1);
+        return;
+    }
+
+    reserve(encoder, (count - 1) * bytes);
+    for (unsigned int i = 1; i < count; ++i)
+    {
+        memcpy(encoder->data + encoder->size, encoder->data + before, bytes);
+        encoder->size += bytes;
+    }
+    advance(encoder, count - 1);
+}
+
+void encoder_put_blanks(encoder_t *const encoder, unsigned int count, bool to_line_end)
+{
+    // erased cells lose attributes, and background too unless terminal has BCE
+    const sgr_state_t *const style = &encoder->style;
+    const bool erasable = encoder->cursor_valid && !encoder->wrap_pending
+        && 0 == (style->attrs & (SGR_UNDERLINE | SGR_REVERSE | SGR_STRIKE))
+        && (SGR_COLOR_DEFAULT == style->bg || encoder->caps.bce);
+
+    // ESC [ K, cursor stays but nothing is left to print on the line
+    if (erasable && to_line_end && count > 3)
+    {
+        encoder_put(encoder, ESC "[K", 3);
+        ++encoder->sequences[ENCODER_SEQ_ERASE];
+        return;
+    }
+
+    // ESC [ n X, cursor stays, so skipping the blanks is paid as well
+    if (erasable && encoder->caps.ech && 2 * csi_cost(count) < count)
+    {
+        put_csi(encoder, count, 'X', ENCODER_SEQ_ERASE);
+        return;
+    }
+
+    encoder_put_char_repeated(encoder, L' ', count);
+}
+
+void encoder_set_style(encoder_t *const encoder, const sgr_state_t *const style)
+{
+    reserve(encoder, SGR_MAX_SEQ);
+    const size_t bytes = sgr_transition(&encoder->style, style, encoder->data + encoder->size);
+    if (bytes) ++encoder->sequences[ENCODER_SEQ_STYLE];
+    encoder->size += bytes;
+    encoder->style = *style;
+}
+
+void encoder_move_to(encoder_t *const encoder, disp_pos_t pos)
+{
+    const disp_pos_t cur = encoder->cursor;
+    if (encoder->cursor_valid && !encoder->wrap_pending && cur.x == pos.x && cur.y == pos.y) return;
+
+    // ESC [ line ; col H
+    unsigned int cost = 4 + digits(pos.y + 1) + digits(pos.x + 1);
+    vert_move_t vert = VERT_ABSOLUTE;
+    horz_move_t horz = HORZ_NONE;
+
+    if (encoder->cursor_valid && encoder->wrap_pending)
+    {
+        // only CR reliably cancels pending wrap, relative moves vary between terminals
+        horz_move_t h;
+        unsigned int c;
+
+        if (pos.y == cur.y)
+        {
+            c = 1 + (pos.x ? csi_cost(pos.x) : 0);
+            if (c < cost) { cost = c; vert = VERT_NONE; horz = HORZ_RETURN; }
+        }
+        else if (pos.y > cur.y)
+        {
+            c = 1 + (pos.y - cur.y) + horz_cost(0, pos.x, &h);
+            if (c < cost) { cost = c; vert = VERT_NEWLINE; horz = h; }
+        }
+    }
+    else if (encoder->cursor_valid)
+    {
+        horz_move_t h;
+        unsigned int c;
+
+        if (pos.y == cur.y)
+        {
+            c = horz_cost(cur.x, pos.x, &h);
+            if (c < cost) { cost = c; vert = VERT_NONE; horz = h; }
+        }
+        else if (pos.y < cur.y)
+        {
+            c = csi_cost(cur.y - pos.y) + horz_cost(cur.x, pos.x, &h);
+            if (c < cost) { cost = c; vert = VERT_UP; horz = h; }
+        }
+        else
+        {
+            c = csi_cost(pos.y - cur.y) + horz_cost(cur.x, pos.x, &h);
+            if (c < cost) { cost = c; vert = VERT_DOWN; horz = h; }
+
+            // CR + LF's land on the first column even with ONLCR enabled
+            c = 1 + (pos.y - cur.y) + horz_cost(0, pos.x, &h);
+            if (c < cost) { cost = c; vert = VERT_NEWLINE; horz = h; }
+        }
+    }
+
+    unsigned int from_x = cur.x;
+    switch (vert)
+    {
+        case VERT_ABSOLUTE: put_cup(encoder, pos); break;
+        case VERT_UP:       put_csi(encoder, cur.y - pos.y, 'A', ENCODER_SEQ_MOVE); break;
+        case VERT_DOWN:     put_csi(encoder, pos.y - cur.y, 'B', ENCODER_SEQ_MOVE); break;
+        case VERT_NEWLINE:  encoder_put(encoder, "\r", 1);
+                            put_repeated(encoder, '\n', pos.y - cur.y);
+                            ++encoder->sequences[ENCODER_SEQ_MOVE];
+                            from_x = 0;
+        break;
+        case VERT_NONE:     break;
+    }
+    switch (horz)
+    {
+        case HORZ_FORWARD:  put_csi(encoder, pos.x - from_x, 'C', ENCODER_SEQ_MOVE); break;
+        case HORZ_BACK:     put_csi(encoder, from_x - pos.x, 'D', ENCODER_SEQ_MOVE); break;
+        case HORZ_RETURN:   encoder_put(encoder, "\r", 1);
+                            ++encoder->sequences[ENCODER_SEQ_MOVE];
+                            if (pos.x) put_csi(encoder, pos.x, 'C', ENCODER_SEQ_MOVE);
+        break;
+        case HORZ_NONE:     break;
+    }
+
+    encoder->cursor = pos;
+    encoder->cursor_valid = true;
+    encoder->wrap_pending = false;
+}
+
+void encoder_scroll(encoder_t *const encoder, unsigned int top, unsigned int bottom, int lines)
+{
+    // terminal fills exposed lines with current background
+    encoder_set_style(encoder, &(sgr_state_t){0});
+
+    const bool whole_screen = 0 == top && bottom + 1u >= encoder->screen.y;
+    if (!whole_screen)
+    {
+        // ESC [ top ; bottom r
+        encoder_put(encoder, ESC "[", 2);
+        encoder_put_uint(encoder, top + 1);
+        encoder_put(encoder, ";", 1);
+        encoder_put_uint(encoder, bottom + 1);
+        encoder_put(encoder, "r", 1);
+        ++encoder->sequences[ENCODER_SEQ_SCROLL];
+    }
+
+    if (lines > 0) put_csi(encoder, lines, 'S', ENCODER_SEQ_SCROLL);
+    else put_csi(encoder, -lines, 'T', ENCODER_SEQ_SCROLL);
+
+    if (!whole_screen || encoder->wrap_pending)
+    {
+        // reset of the region homes the cursor
+        if (!whole_screen) encoder_put_seq(encoder, ESC "[r", ENCODER_SEQ_SCROLL);
+        encoder->cursor_valid = false;
+    }
+}
+
+void encoder_shift_line(encoder_t *const encoder, unsigned int line, int cols)
+{
+    encoder_set_style(encoder, &(sgr_state_t){0});
+    encoder_move_to(encoder, (disp_pos_t){0, line});
+    if (cols > 0) put_csi(encoder, cols, 'P', ENCODER_SEQ_SCROLL);
+    else put_csi(encoder, -cols, '@', ENCODER_SEQ_SCROLL);
+}
+
+int encoder_flush(encoder_t *const encoder, int fd)
+{
+    while (encoder->sent < encoder->size)
+    {
+        ssize_t bytes = write(fd, encoder->data + encoder->sent, encoder->size - encoder->sent);
+        if (-1 == bytes)
+        {
+            if (EINTR == errno) continue;
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                // terminal is busy, rest of the frame waits for it
+                int queued = 0;
+                if (0 == ioctl(fd, TIOCOUTQ, &queued)) encoder->stats.queued = queued;
+                encoder->draining = true;
+                return EAGAIN;
+            }
+
+            // terminal is the output, error goes to the log
+            int error = errno;
+            S_LOG(LOGGER_CRITICAL, "encoder_flush: %s\n", strerror(error));
+            encoder->size = 0;
+            encoder->sent = 0;
+            encoder->draining = false;
+            return error;
+        }
+        ++encoder->stats.writes;
+        encoder->sent += bytes;
+        encoder->stats.total_bytes += bytes;
+    }
+
+    ++encoder->stats.frames;
+    encoder->stats.last_bytes = encoder->size;
+    encoder->size = 0;
+    encoder->sent = 0;
+    encoder->draining = false;
+    return 0;
+}
+
+static void put_glyph(encoder_t *const encoder, wchar_t ch)
+{
+    reserve(encoder, MB_LEN_MAX > UTF8_MAX ? MB_LEN_MAX : UTF8_MAX);
+    char *const out = encoder->data + encoder->size;
+
+    if (ch >= 0 && ch < 0x80) // ASCII is the same in every charset
+    {
+        *out = (char) ch;
+        encoder->size += 1;
+    }
+    else if (!encoder->caps.legacy_charset)
+    {
+        encoder->size += utf8_encode(ch, out);
+    }
+    else
+    {
+        mbstate_t state = {0};
+        size_t bytes = wcrtomb(out, ch, &state);
+        if ((size_t) -1 == bytes) // not representable in current locale
+        {
+            *out = '?';
+            bytes = 1;
+        }
+        encoder->size += bytes;
+    }
+}
+
+static unsigned int digits(unsigned int value)
+{
+    unsigned int n = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        ++n;
+    }
+    return n;
+}
+
+/* Size of `ESC [ n X`, parameter is omitted when equals to 1 */
+static unsigned int csi_cost(unsigned int n)
+{
+    return 3 + (n == 1 ? 0 : digits(n));
+}
+
+static unsigned int horz_cost(unsigned int from, unsigned int to, horz_move_t *move)
+{
+    if (from == to)
+    {
+        *move = HORZ_NONE;
+        return 0;
+    }
+    if (to > from)
+    {
+        *move = HORZ_FORWARD;
+        return csi_cost(to - from);
+    }
+
+    const unsigned int back_cost = csi_cost(from - to);
+    const unsigned int return_cost = 1 + (to ? csi_cost(to) : 0);
+    *move = (return_cost < back_cost) ? HORZ_RETURN : HORZ_BACK;
+    return (return_cost < back_cost) ? return_cost : back_cost;
+}
+
+static void advance(encoder_t *const encoder, unsigned int cols)
+{
+    // printing with pending wrap continues on the next line, not worth tracking
+    if (encoder->wrap_pending) encoder->cursor_valid = false;
+
+    // cursor stays at the last column until the next character wraps it
+    const unsigned int x = encoder->cursor.x + cols;
+    encoder->wrap_pending = x >= encoder->screen.x;
+    encoder->cursor.x = encoder->wrap_pending ? encoder->screen.x - 1u : x;
+}
+
+static void put_cup(encoder_t *const encoder, disp_pos_t pos)
+{
+    encoder_put(encoder, ESC "[", 2);
+    encoder_put_uint(encoder, pos.y + 1);
+    encoder_put(encoder, ";", 1);
+    encoder_put_uint(encoder, pos.x + 1);
+    encoder_put(encoder, "H", 1);
+    ++encoder->sequences[ENCODER_SEQ_MOVE];
+}
+
+static void put_csi(encoder_t *const encoder, unsigned int n, char final, encoder_seq_t kind)
+{
+    encoder_put(encoder, ESC "[", 2);
+    if (n != 1) encoder_put_uint(encoder, n);
+    encoder_put(encoder, &final, 1);
+    ++encoder->sequences[kind];
+}
+
+static void put_repeated(encoder_t *const encoder, char ch, unsigned int times)
+{
+    reserve(encoder, times);
+    memset(encoder->data + encoder->size, ch, times);
+    encoder->size += times;
+}
+
+static void reserve(encoder_t *const encoder, size_t amount)
+{
+    if (encoder->size + amount <= encoder->capacity) return;
+
+    size_t capacity = encoder->capacity ? encoder->capacity : ENCODER_INITIAL_CAP;
+    while (capacity < encoder->size + amount) capacity *= 2;
+
+    char *data = realloc(encoder->data, capacity);
+    if (!data)
+    {
+        perror("encoder");
+        exit(EXIT_FAILURE);
+    }
+    encoder->data = data;
+    encoder->capacity = capacity;
+}
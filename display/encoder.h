@@ -0,0 +1,160 @@
+#ifndef _ENCODER_H_
+#define _ENCODER_H_
+
+#include "cluster.h"
+#include "display_types.h"
+#include "logger.h"
+#include "sgr.h"
+#include "termcaps.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+
+#define ENCODER_INITIAL_CAP 16*1024 // 16kb
+
+/* Kinds of escape sequences counted per frame */
+typedef enum
+{
+    ENCODER_SEQ_MOVE,   /* cursor positioning, CR/LF included */
+    ENCODER_SEQ_STYLE,  /* SGR                                */
+    ENCODER_SEQ_ERASE,  /* EL, ECH                            */
+    ENCODER_SEQ_REPEAT, /* REP                                */
+    ENCODER_SEQ_SCROLL, /* scroll regions, SU/SD, DCH/ICH     */
+    ENCODER_SEQ_MODE,   /* cursor visibility, synchronized output */
+    ENCODER_SEQ_KINDS
+}
+encoder_seq_t;
+
+/* Counters accumulated by `encoder_flush` */
+typedef struct
+{
+    size_t frames;      /* frames pushed to the terminal   */
+    size_t writes;      /* write(2) calls issued           */
+    size_t last_bytes;  /* bytes emitted by the last frame */
+    size_t total_bytes; /* bytes emitted since init        */
+    size_t dropped;     /* frames merged into a later one as output was busy */
+    size_t queued;      /* bytes in the tty output queue when a frame last blocked */
+    uint64_t encode_ns; /* time spent diffing and encoding the last frame */
+    uint64_t write_ns;  /* time spent writing the last frame out          */
+}
+encoder_stats_t;
+
+/*
+ * Serializes a frame into one reusable byte buffer,
+ * so it can be pushed to the terminal with a single write.
+ * Zero initialized encoder is valid, storage is allocated on first use.
+ */
+typedef struct
+{
+    char   *data;
+    size_t  size;
+    size_t  capacity;
+    size_t  sent;      /* bytes of the frame already written */
+    bool    draining;  /* frame is partially written, output would block */
+    encoder_stats_t stats;
+
+    disp_pos_t screen; /* size of the screen for the current frame   */
+    disp_pos_t cursor; /* where terminal cursor is after the output */
+    bool cursor_valid; /* cursor position is unknown when false     */
+    bool wrap_pending; /* last column was printed, cursor did not move */
+    sgr_state_t style; /* graphic rendition the terminal is in      */
+    term_caps_t caps;  /* optional sequences the terminal understands */
+    size_t sequences[ENCODER_SEQ_KINDS]; /* emitted since `encoder_begin_frame` */
+}
+encoder_t;
+
+void encoder_deinit(encoder_t *const encoder);
+
+/* Forgets terminal cursor position, as it could be moved by anyone between frames */
+void
+encoder_begin_frame(encoder_t *const encoder,
+        disp_pos_t screen);
+
+/* Brings terminal back to the default style, so frame leaves no trace */
+void encoder_end_frame(encoder_t *const encoder);
+
+void
+encoder_put(encoder_t *const encoder,
+        const char *const bytes,
+        size_t size);
+void
+encoder_puts(encoder_t *const encoder,
+        const char *const string);
+/* Appends a complete escape sequence and counts it as `kind` */
+void
+encoder_put_seq(encoder_t *const encoder,
+        const char *const sequence,
+        encoder_seq_t kind);
+void
+encoder_put_uint(encoder_t *const encoder,
+        unsigned int value);
+/* Prints a character and advances tracked cursor */
+void
+encoder_put_char(encoder_t *const encoder,
+        wchar_t ch);
+/* Prints a glyph taking two columns and advances tracked cursor by both */
+void
+encoder_put_wide_char(encoder_t *const encoder,
+        wchar_t ch);
+/* Prints base character with its combining marks, they take `width` columns */
+void
+encoder_put_cluster(encoder_t *const encoder,
+        const cluster_t *const cluster,
+        unsigned int width);
+/* Prints a character `count` times, with REP when it is supported and shorter */
+void
+encoder_put_char_repeated(encoder_t *const encoder,
+        wchar_t ch,
+        unsigned int count);
+/*
+ * Prints `count` spaces in the current style, or erases them with ECH or EL
+ * when it is shorter and erased cells look the same.
+ * `to_line_end` tells that the blanks reach the last column.
+ */
+void
+encoder_put_blanks(encoder_t *const encoder,
+        unsigned int count,
+        bool to_line_end);
+/* Emits only parameters that differ from the current terminal style */
+void
+encoder_set_style(encoder_t *const encoder,
+        const sgr_state_t *const style);
+/*
+ * Moves cursor with the cheapest sequence available:
+ * nothing when already there, relative moves for short jumps
+ * and absolute CUP otherwise.
+ */
+void
+encoder_move_to(encoder_t *const encoder,
+        disp_pos_t pos);
+
+/*
+ * Scrolls lines `top..bottom` by `lines` within a temporary scroll region,
+ * positive `lines` move content up. Exposed lines are blank in default style.
+ */
+void
+encoder_scroll(encoder_t *const encoder,
+        unsigned int top,
+        unsigned int bottom,
+        int lines);
+/*
+ * Shifts content of the `line` by `cols` with DCH/ICH,
+ * positive `cols` move content left. Exposed cells are blank in default style.
+ */
+void
+encoder_shift_line(encoder_t *const encoder,
+        unsigned int line,
+        int cols);
+
+/*
+ * Writes the buffer to `fd` and resets it for the next frame.
+ * With non-blocking `fd` the rest of the frame is kept and EAGAIN is returned,
+ * call it again once `fd` is writable. Nothing new may be encoded meanwhile.
+ * Returns 0 when the frame is written, otherwise errno of the failed write.
+ * On other errors the frame is discarded, the screen is left unknown.
+ */
+int encoder_flush(encoder_t *const encoder, int fd);
+
+#endif//_ENCODER_H_
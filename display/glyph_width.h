@@ -0,0 +1,27 @@
+#ifndef _GLYPH_WIDTH_H_
+#define _GLYPH_WIDTH_H_
+
+#include <stdint.h>
+
+#define GLYPH_WIDTH_CODEPOINTS 0x110000
+#define GLYPH_WIDTH_BLOCK      256
+
+/*
+ * Two-stage table generated by glyph_width.py: stage1 maps a block of
+ * code points to its row in stage2, rows hold 2 bits of width per code point.
+ * Equal blocks share a row, so the tables stay small.
+ */
+extern const uint8_t glyph_width_stage1[GLYPH_WIDTH_CODEPOINTS / GLYPH_WIDTH_BLOCK];
+extern const uint8_t glyph_width_stage2[][GLYPH_WIDTH_BLOCK / 4];
+
+/* Columns the code point takes: 0 for controls and combining marks, 2 for wide glyphs */
+static inline unsigned int
+glyph_width(uint32_t cp)
+{
+    if (cp >= GLYPH_WIDTH_CODEPOINTS) return 1;
+    const uint8_t *const block = glyph_width_stage2[glyph_width_stage1[cp / GLYPH_WIDTH_BLOCK]];
+    const unsigned int offset = cp % GLYPH_WIDTH_BLOCK;
+    return (block[offset / 4] >> (offset % 4 * 2)) & 3;
+}
+
+#endif//_GLYPH_WIDTH_H_
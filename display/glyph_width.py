@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Generates glyph_width.c, the two-stage table of columns per code point.
+
+Widths come from the Unicode database bundled with Python:
+    0  controls, nonspacing and enclosing marks, format characters,
+       hangul medial vowels and final consonants
+    2  East Asian Wide and Fullwidth, planes 2 and 3
+    1  everything else, unassigned code points included
+
+Usage: ./glyph_width.py > glyph_width.c
+"""
+
+import sys
+import unicodedata
+
+CODEPOINTS = 0x110000
+BLOCK = 256        # code points per second stage block
+PER_BYTE = 4       # 2 bits per code point
+
+# format characters with a visible glyph: soft hyphen, prepended concatenation marks
+SHOWN_FORMAT = {0x00ad, *range(0x0600, 0x0606), 0x06dd, 0x070f, 0x0890, 0x0891,
+                0x08e2, 0x110bd, 0x110cd}
+
+
+def width(cp):
+    ch = chr(cp)
+    category = unicodedata.category(ch)
+    if category in ('Cc', 'Mn', 'Me') or 0x1160 <= cp <= 0x11ff or 0xd7b0 <= cp <= 0xd7ff:
+        return 0
+    if category == 'Cf' and cp not in SHOWN_FORMAT:
+        return 0
+    if 0x20000 <= cp <= 0x2fffd or 0x30000 <= cp <= 0x3fffd:
+        return 2
+    # the database has no East Asian width for unassigned code points
+    if category != 'Cn' and unicodedata.east_asian_width(ch) in ('W', 'F'):
+        return 2
+    return 1
+
+
+def main():
+    blocks = []
+    index = {}
+    stage1 = []
+    for first in range(0, CODEPOINTS, BLOCK):
+        packed = bytearray(BLOCK // PER_BYTE)
+        for cp in range(first, first + BLOCK):
+            offset = cp - first
+            packed[offset // PER_BYTE] |= width(cp) << (offset % PER_BYTE * 2)
+        packed = bytes(packed)
+        if packed not in index:
+            index[packed] = len(blocks)
+            blocks.append(packed)
+        stage1.append(index[packed])
+    assert len(blocks) <= 256, 'block index must fit a byte'
+
+    out = sys.stdout
+    out.write('/* Generated by glyph_width.py from Unicode %s, do not edit */\n'
+              % unicodedata.unidata_version)
+    out.write('#include "glyph_width.h"\n\n')
+    out.write('const uint8_t glyph_width_stage1[GLYPH_WIDTH_CODEPOINTS / GLYPH_WIDTH_BLOCK] = {\n')
+    for row in range(0, len(stage1), 16):
+        out.write('    ' + ' '.join('%3d,' % b for b in stage1[row:row + 16]) + '\n')
+    out.write('};\n\n')
+    out.write('const uint8_t glyph_width_stage2[][GLYPH_WIDTH_BLOCK / 4] = {\n')
+    for packed in blocks:
+        out.write('    {\n')
+        for row in range(0, len(packed), 16):
+            out.write('        ' + ' '.join('0x%02x,' % b for b in packed[row:row + 16]) + '\n')
+        out.write('    },\n')
+    out.write('};\n')
+
+
+if __name__ == '__main__':
+    main()
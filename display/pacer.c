@@ -0,0 +1,94 @@
+#include "pacer.h"
+#include "clock.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+int pacer_set_max_fps(pacer_t *const pacer, unsigned int max_fps)
+{
+    if (!pacer->has_timer)
+    {
+        int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (-1 == fd)
+        {
+            perror("timerfd_create");
+            return errno;
+        }
+        pacer->timerfd = fd;
+        pacer->has_timer = true;
+    }
+
+    pacer->max_fps = max_fps;
+    pacer->interval_ns = max_fps ? NS_IN_SEC / max_fps : 0;
+    return 0;
+}
+
+void pacer_deinit(pacer_t *const pacer)
+{
+    if (pacer->has_timer) close(pacer->timerfd);
+    *pacer = (pacer_t){0};
+}
+
+bool pacer_frame_due(pacer_t *const pacer)
+{
+    const uint64_t now = clock_now_ns();
+    const uint64_t slot = pacer->last_ns + pacer->interval_ns;
+
+    if (!pacer->scheduled)
+    {
+        pacer->deadline_ns = (now > slot) ? now : slot;
+        pacer->scheduled = true;
+    }
+
+    if (!pacer->has_timer || 0 == pacer->interval_ns || now >= slot)
+    {
+        return true;
+    }
+
+    if (!pacer->armed)
+    {
+        struct itimerspec spec = {
+            .it_value = {
+                .tv_sec = slot / NS_IN_SEC,
+                .tv_nsec = slot % NS_IN_SEC,
+            },
+        };
+        if (-1 == timerfd_settime(pacer->timerfd, TFD_TIMER_ABSTIME, &spec, NULL))
+        {
+            perror("timerfd_settime");
+            return true; // better draw early than never
+        }
+        pacer->armed = true;
+    }
+    return false;
+}
+
+void pacer_presented(pacer_t *const pacer)
+{
+    const uint64_t now = clock_now_ns();
+
+    // frame is late when it did not make it before the following slot
+    if (pacer->interval_ns && now > pacer->deadline_ns + pacer->interval_ns)
+    {
+        ++pacer->missed;
+    }
+    ++pacer->presented;
+    pacer->last_ns = now;
+    pacer->scheduled = false;
+    if (pacer->armed)
+    {
+        // frame went out early (unpaced render), drop the stale slot
+        (void) timerfd_settime(pacer->timerfd, 0, &(struct itimerspec){0}, NULL);
+        pacer->armed = false;
+    }
+}
+
+void pacer_on_timer(pacer_t *const pacer)
+{
+    uint64_t expirations;
+    (void) read(pacer->timerfd, &expirations, sizeof(expirations));
+    pacer->armed = false;
+}
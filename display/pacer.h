@@ -0,0 +1,47 @@
+#ifndef _PACER_H_
+#define _PACER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Limits presents to `max_fps` frames per second.
+ * When a frame is requested too early, a timerfd is armed for the next slot,
+ * so the event loop sleeps instead of spinning and invalidations coalesce.
+ * Zero initialized pacer is unlimited and has no timer.
+ */
+typedef struct
+{
+    int      timerfd;     /* readable when the next slot begins      */
+    bool     has_timer;
+    bool     armed;       /* timer is set for the pending frame      */
+    bool     scheduled;   /* pending frame has its deadline assigned */
+    unsigned max_fps;     /* 0 - unlimited                           */
+    uint64_t interval_ns; /* minimal time between presents           */
+    uint64_t last_ns;     /* when last frame was presented           */
+    uint64_t deadline_ns; /* slot the pending frame is scheduled for */
+
+    size_t   presented;   /* frames presented                        */
+    size_t   missed;      /* frames presented after their slot ended */
+}
+pacer_t;
+
+/* Creates the timer on first call, returns 0 or errno */
+int pacer_set_max_fps(pacer_t *const pacer, unsigned int max_fps);
+
+void pacer_deinit(pacer_t *const pacer);
+
+/*
+ * Returns true when a frame may be presented right now,
+ * otherwise arms the timer for the next slot and returns false.
+ */
+bool pacer_frame_due(pacer_t *const pacer);
+
+/* Records a finished present and checks it against its deadline */
+void pacer_presented(pacer_t *const pacer);
+
+/* Consumes timer expiration, call when `timerfd` is readable */
+void pacer_on_timer(pacer_t *const pacer);
+
+#endif//_PACER_H_
@@ -0,0 +1,195 @@
+#include "rowdiff.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ROWDIFF_X86
+#include <immintrin.h>
+#endif
+
+#define CELL_SIZE sizeof(uint64_t)
+
+/* Accumulates runs out of per-block change masks */
+typedef struct
+{
+    disp_span_t *runs;
+    size_t       count;
+    bool         open;
+}
+runs_builder_t;
+
+/* helpers are inlined into each kernel to stay within its instruction set */
+#define KERNEL_HELPER static inline __attribute__((always_inline))
+
+KERNEL_HELPER void push_mask(runs_builder_t *const builder, unsigned int base, uint32_t mask, unsigned int bits);
+KERNEL_HELPER void push_cell(runs_builder_t *const builder, unsigned int col, bool changed);
+KERNEL_HELPER size_t scalar_tail(runs_builder_t *const builder, const unsigned char *a, const unsigned char *b,
+        unsigned int col, unsigned int last);
+
+rowdiff_t rowdiff_select(void)
+{
+    const char *forced = getenv("TIFC_ROWDIFF");
+    if (forced && 0 == strcmp(forced, "scalar")) return rowdiff_scalar;
+
+#ifdef ROWDIFF_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return rowdiff_avx2;
+    // sse2 kernel loses to scalar once blocks have changes, it is not picked
+#endif
+    return rowdiff_scalar;
+}
+
+size_t rowdiff_scalar(const void *const a, const void *const b,
+        unsigned int first, unsigned int last, disp_span_t runs[])
+{
+    runs_builder_t builder = {.runs = runs};
+    return scalar_tail(&builder, a, b, first, last);
+}
+
+#ifdef ROWDIFF_X86
+
+__attribute__((target("sse2")))
+size_t rowdiff_sse2(const void *const a, const void *const b,
+        unsigned int first, unsigned int last, disp_span_t runs[])
+{
+    const unsigned char *pa = a;
+    const unsigned char *pb = b;
+    runs_builder_t builder = {.runs = runs};
+    unsigned int col = first;
+
+    // 16 cells per iteration, two cells per register
+    for (; col + 16 <= last + 1; col += 16)
+    {
+        __m128i equal[8];
+        __m128i all = _mm_set1_epi32(-1);
+        for (unsigned int v = 0; v < 8; ++v)
+        {
+            const size_t offset = (size_t) (col + v * 2) * CELL_SIZE;
+            equal[v] = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) (pa + offset)),
+                                       _mm_loadu_si128((const __m128i *) (pb + offset)));
+            all = _mm_and_si128(all, equal[v]);
+        }
+
+        // most of the blocks are unchanged, check them at once
+        if (0xffff == _mm_movemask_epi8(all))
+        {
+            builder.open = false;
+            continue;
+        }
+
+        uint32_t mask = 0;
+        for (unsigned int v = 0; v < 4; ++v)
+        {
+            // cell is equal only when both of its 32 bit halves are, pair the halves of 4 cells
+            const __m128 low = _mm_castsi128_ps(equal[v * 2]);
+            const __m128 high = _mm_castsi128_ps(equal[v * 2 + 1]);
+            const __m128 cells = _mm_and_ps(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)),
+                                            _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+            mask |= (~_mm_movemask_ps(cells) & 0xf) << (v * 4);
+        }
+        push_mask(&builder, col, mask, 16);
+    }
+
+    return scalar_tail(&builder, pa, pb, col, last);
+}
+
+__attribute__((target("avx2")))
+size_t rowdiff_avx2(const void *const a, const void *const b,
+        unsigned int first, unsigned int last, disp_span_t runs[])
+{
+    const unsigned char *pa = a;
+    const unsigned char *pb = b;
+    runs_builder_t builder = {.runs = runs};
+    unsigned int col = first;
+
+    // 16 cells per iteration, four cells per register
+    for (; col + 16 <= last + 1; col += 16)
+    {
+        __m256i x[4];
+        __m256i y[4];
+        __m256i any = _mm256_setzero_si256();
+        for (unsigned int v = 0; v < 4; ++v)
+        {
+            const size_t offset = (size_t) (col + v * 4) * CELL_SIZE;
+            x[v] = _mm256_loadu_si256((const __m256i *) (pa + offset));
+            y[v] = _mm256_loadu_si256((const __m256i *) (pb + offset));
+            any = _mm256_or_si256(any, _mm256_xor_si256(x[v], y[v]));
+        }
+
+        // most of the blocks are unchanged, check them at once
+        if (_mm256_testz_si256(any, any))
+        {
+            builder.open = false;
+            continue;
+        }
+
+        uint32_t mask = 0;
+        for (unsigned int v = 0; v < 4; ++v)
+        {
+            __m256i equal = _mm256_cmpeq_epi64(x[v], y[v]);
+            mask |= (~_mm256_movemask_pd(_mm256_castsi256_pd(equal)) & 0xf) << (v * 4);
+        }
+        push_mask(&builder, col, mask, 16);
+    }
+
+    return scalar_tail(&builder, pa, pb, col, last);
+}
+
+#endif // ROWDIFF_X86
+
+KERNEL_HELPER size_t scalar_tail(runs_builder_t *const builder, const unsigned char *a, const unsigned char *b,
+        unsigned int col, unsigned int last)
+{
+    for (; col <= last; ++col)
+    {
+        uint64_t x, y;
+        memcpy(&x, a + (size_t) col * CELL_SIZE, CELL_SIZE);
+        memcpy(&y, b + (size_t) col * CELL_SIZE, CELL_SIZE);
+        push_cell(builder, col, x != y);
+    }
+    return builder->count;
+}
+
+KERNEL_HELPER void push_mask(runs_builder_t *const builder, unsigned int base, uint32_t mask, unsigned int bits)
+{
+    unsigned int bit = 0;
+    while (bit < bits)
+    {
+        // walk over runs of equal bits instead of single cells
+        const uint32_t rest = mask >> bit;
+        const bool changed = rest & 1;
+        const uint32_t run_bits = changed ? ~rest : rest;
+        unsigned int length = run_bits ? (unsigned int) __builtin_ctz(run_bits) : bits - bit;
+        if (bit + length > bits) length = bits - bit;
+
+        if (!changed)
+        {
+            builder->open = false;
+        }
+        else
+        {
+            push_cell(builder, base + bit, true);
+            builder->runs[builder->count - 1].last = base + bit + length - 1;
+        }
+        bit += length;
+    }
+}
+
+KERNEL_HELPER void push_cell(runs_builder_t *const builder, unsigned int col, bool changed)
+{
+    if (!changed)
+    {
+        builder->open = false;
+    }
+    else if (builder->open)
+    {
+        builder->runs[builder->count - 1].last = col;
+    }
+    else
+    {
+        builder->runs[builder->count++] = (disp_span_t){col, col};
+        builder->open = true;
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef _ROWDIFF_H_
+#define _ROWDIFF_H_
+
+#include "display_types.h"
+
+#include <stddef.h>
+
+/* Worst case amount of runs for a row: every other cell changed */
+#define ROWDIFF_MAX_RUNS(cols) ((cols) / 2 + 1)
+
+/*
+ * Compares cells `first..last` of two rows of packed 8 byte cells
+ * and stores runs of changed columns into `runs`.
+ * Returns amount of runs stored.
+ */
+typedef size_t (*rowdiff_t)(const void *const a,
+        const void *const b,
+        unsigned int first,
+        unsigned int last,
+        disp_span_t runs[]);
+
+/* Picks the fastest kernel supported by the running cpu */
+rowdiff_t rowdiff_select(void);
+
+/* Portable kernel, always available */
+size_t rowdiff_scalar(const void *const a,
+        const void *const b,
+        unsigned int first,
+        unsigned int last,
+        disp_span_t runs[]);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ROWDIFF_X86
+
+/* Kept for comparison, slower than scalar on changed rows so never selected */
+size_t rowdiff_sse2(const void *const a,
+        const void *const b,
+        unsigned int first,
+        unsigned int last,
+        disp_span_t runs[]);
+
+size_t rowdiff_avx2(const void *const a,
+        const void *const b,
+        unsigned int first,
+        unsigned int last,
+        disp_span_t runs[]);
+#endif
+
+#endif//_ROWDIFF_H_
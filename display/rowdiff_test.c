@@ -0,0 +1,113 @@
+#include "rowdiff.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define COLS 512
+#define ROWS 64
+#define ROUNDS 2000
+
+typedef struct
+{
+    const char *name;
+    rowdiff_t kernel;
+}
+kernel_t;
+
+/* the loop display_render_area used before: memcmp per cell */
+static size_t rowdiff_per_cell(const void *const a, const void *const b,
+        unsigned int first, unsigned int last, disp_span_t runs[])
+{
+    size_t count = 0;
+    bool open = false;
+    for (unsigned int col = first; col <= last; ++col)
+    {
+        if (memcmp((const uint64_t *) a + col, (const uint64_t *) b + col, sizeof(uint64_t)))
+        {
+            if (open) runs[count - 1].last = col;
+            else runs[count++] = (disp_span_t){col, col};
+            open = true;
+        }
+        else open = false;
+    }
+    return count;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill(uint64_t *a, uint64_t *b, unsigned int permille)
+{
+    for (size_t i = 0; i < (size_t) COLS * ROWS; ++i)
+    {
+        a[i] = b[i] = ((uint64_t) rand() << 32) | rand();
+        if ((unsigned int) rand() % 1000 < permille) b[i] ^= 1ull << (rand() % 64);
+    }
+}
+
+int main(void)
+{
+    static uint64_t a[COLS * ROWS];
+    static uint64_t b[COLS * ROWS];
+    static disp_span_t expected[ROWDIFF_MAX_RUNS(COLS)];
+    static disp_span_t runs[ROWDIFF_MAX_RUNS(COLS)];
+
+    const kernel_t kernels[] = {
+        {"per-cell", rowdiff_per_cell},
+        {"scalar",   rowdiff_scalar},
+#ifdef ROWDIFF_X86
+        {"sse2",     rowdiff_sse2},
+        {"avx2",     __builtin_cpu_supports("avx2") ? rowdiff_avx2 : NULL},
+#endif
+        {"selected", rowdiff_select()},
+    };
+    const unsigned int densities[] = {0, 10, 100, 1000}; // changed cells, permille
+
+    for (size_t d = 0; d < sizeof(densities) / sizeof(*densities); ++d)
+    {
+        fill(a, b, densities[d]);
+        printf("changed %4.1f%%:\n", densities[d] / 10.0);
+
+        for (size_t k = 0; k < sizeof(kernels) / sizeof(*kernels); ++k)
+        {
+            if (!kernels[k].kernel) continue;
+
+            // correctness against the reference, including unaligned spans
+            for (unsigned int row = 0; row < ROWS; ++row)
+            {
+                unsigned int first = row % 13;
+                unsigned int last = COLS - 1 - row % 7;
+                const uint64_t *ra = a + (size_t) row * COLS;
+                const uint64_t *rb = b + (size_t) row * COLS;
+                size_t n = rowdiff_per_cell(ra, rb, first, last, expected);
+                size_t m = kernels[k].kernel(ra, rb, first, last, runs);
+                assert(n == m);
+                assert(0 == memcmp(expected, runs, n * sizeof(disp_span_t)));
+            }
+
+            size_t total = 0;
+            double start = now();
+            for (unsigned int round = 0; round < ROUNDS; ++round)
+            {
+                for (unsigned int row = 0; row < ROWS; ++row)
+                {
+                    total += kernels[k].kernel(a + (size_t) row * COLS,
+                            b + (size_t) row * COLS, 0, COLS - 1, runs);
+                }
+            }
+            double elapsed = now() - start;
+            printf("  %-8s %8.1f Mcells/s (%zu runs)\n", kernels[k].name,
+                    (double) COLS * ROWS * ROUNDS / elapsed / 1e6, total / ROUNDS);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "scroll.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME  0x100000001b3ull
+
+uint64_t scroll_hash_row(const void *const cells, unsigned int cols)
+{
+    // FNV-1a over whole cells rather than bytes
+    const unsigned char *bytes = cells;
+    uint64_t hash = FNV_OFFSET;
+    for (unsigned int col = 0; col < cols; ++col)
+    {
+        uint64_t cell;
+        memcpy(&cell, bytes + (size_t) col * sizeof(cell), sizeof(cell));
+        hash = (hash ^ cell) * FNV_PRIME;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+scroll_region_t scroll_detect(const uint64_t *const now, const uint64_t *const before,
+        unsigned int rows, unsigned int max_shift)
+{
+    scroll_region_t best = {0};
+    unsigned int best_gain = SCROLL_MIN_GAIN - 1;
+    if (max_shift >= rows) max_shift = rows ? rows - 1 : 0;
+
+    for (int shift = -(int) max_shift; shift <= (int) max_shift; ++shift)
+    {
+        if (0 == shift) continue;
+
+        // rows that would land where the new frame expects them
+        unsigned int first = shift < 0 ? -shift : 0;
+        unsigned int last = shift > 0 ? rows - 1 - shift : rows - 1;
+
+        bool in_run = false;
+        unsigned int run_start = 0;
+        unsigned int gain = 0;
+        for (unsigned int y = first; y <= last + 1; ++y)
+        {
+            if (y <= last && now[y] == before[y + shift])
+            {
+                if (!in_run)
+                {
+                    in_run = true;
+                    run_start = y;
+                    gain = 0;
+                }
+                // rows that are already in place are not saved by scrolling
+                if (now[y] != before[y]) ++gain;
+                continue;
+            }
+
+            if (in_run && gain > best_gain)
+            {
+                best_gain = gain;
+                best.lines = shift;
+                best.top = shift > 0 ? run_start : run_start + shift;
+                best.bottom = shift > 0 ? y - 1 + shift : y - 1;
+            }
+            in_run = false;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,36 @@
+#ifndef _SCROLL_H_
+#define _SCROLL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fewer rows saved than that do not pay for the scroll sequences */
+#define SCROLL_MIN_GAIN 2
+
+/* Widest sideways shift tried for lines */
+#define SCROLL_MAX_COLS 16
+
+/* Lines `top..bottom` of the screen moved by `lines`, positive is up */
+typedef struct
+{
+    int      lines; /* 0 - no scroll detected */
+    uint16_t top;
+    uint16_t bottom;
+}
+scroll_region_t;
+
+/* Hash of a row of packed 8 byte cells */
+uint64_t scroll_hash_row(const void *const cells, unsigned int cols);
+
+/*
+ * Finds translation of rows that saves the most repainted rows,
+ * `now` and `before` are row hashes of the new frame and of the screen.
+ * Only shifts up to `max_shift` rows are tried.
+ */
+scroll_region_t
+scroll_detect(const uint64_t *const now,
+        const uint64_t *const before,
+        unsigned int rows,
+        unsigned int max_shift);
+
+#endif//_SCROLL_H_
@@ -0,0 +1,204 @@
+#include "sgr.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SGR_ATTRS 9
+
+typedef struct
+{
+    char data[SGR_MAX_SEQ];
+    size_t size;
+}
+params_t;
+
+/* parameter that turns attribute on and off, indexed by bit */
+static const unsigned char attr_on[SGR_ATTRS]  = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+static const unsigned char attr_off[SGR_ATTRS] = {22, 22, 23, 24, 25, 25, 27, 28, 29};
+
+static void put_param(params_t *const params, unsigned int value);
+static void put_color(params_t *const params, sgr_color_t color, bool background);
+static void put_changes(params_t *const params, const sgr_state_t *const from, const sgr_state_t *const to);
+static sgr_color_t parse_extended_color(const char **seq);
+static bool parse_uint(const char **seq, unsigned int *value);
+
+sgr_state_t sgr_parse(const char *seq)
+{
+    sgr_state_t state = {0};
+    if (!seq) return state;
+
+    while ((seq = strchr(seq, '[')))
+    {
+        seq = sgr_apply(&state, seq + 1);
+    }
+
+    return state;
+}
+
+const char *sgr_apply(sgr_state_t *const state, const char *params)
+{
+    unsigned int code = 0;
+    do
+    {
+        if (*params == ';') ++params;
+        if (!parse_uint(&params, &code)) code = 0; // empty parameter is a reset
+
+        if (code == 0)                      *state = (sgr_state_t){0};
+        else if (code <= SGR_ATTRS)         state->attrs |= 1 << (code - 1);
+        else if (code == 22)                state->attrs &= ~(SGR_BOLD | SGR_DIM);
+        else if (code == 25)                state->attrs &= ~(SGR_BLINK | SGR_RAPID_BLINK);
+        else if (code >= 23 && code <= 29)  state->attrs &= ~(1 << (code - 21));
+        else if (code >= 30 && code <= 37)  state->fg = SGR_COLOR_BASIC(code - 30);
+        else if (code == 38)                state->fg = parse_extended_color(&params);
+        else if (code == 39)                state->fg = SGR_COLOR_DEFAULT;
+        else if (code >= 40 && code <= 47)  state->bg = SGR_COLOR_BASIC(code - 40);
+        else if (code == 48)                state->bg = parse_extended_color(&params);
+        else if (code == 49)                state->bg = SGR_COLOR_DEFAULT;
+        else if (code >= 90 && code <= 97)  state->fg = SGR_COLOR_BASIC(code - 90 + 8);
+        else if (code >= 100 && code <= 107) state->bg = SGR_COLOR_BASIC(code - 100 + 8);
+    }
+    while (*params == ';');
+
+    return params;
+}
+
+int sgr_equal(const sgr_state_t *const a, const sgr_state_t *const b)
+{
+    return a->fg == b->fg && a->bg == b->bg && a->attrs == b->attrs;
+}
+
+size_t sgr_transition(const sgr_state_t *const from,
+        const sgr_state_t *const to,
+        char out[static SGR_MAX_SEQ])
+{
+    if (sgr_equal(from, to)) return 0;
+
+    params_t changes = {0};
+    put_changes(&changes, from, to);
+
+    params_t reset = {0};
+    put_param(&reset, 0);
+    put_changes(&reset, &(sgr_state_t){0}, to);
+
+    const params_t *const best = (reset.size < changes.size) ? &reset : &changes;
+
+    size_t size = 0;
+    out[size++] = '\x1b';
+    out[size++] = '[';
+    memcpy(out + size, best->data, best->size);
+    size += best->size;
+    out[size++] = 'm';
+    return size;
+}
+
+static void put_changes(params_t *const params,
+        const sgr_state_t *const from,
+        const sgr_state_t *const to)
+{
+    unsigned int removed = from->attrs & ~to->attrs;
+    unsigned int added = to->attrs & ~from->attrs;
+
+    for (unsigned int bit = 0; bit < SGR_ATTRS; ++bit)
+    {
+        if (!(removed & (1 << bit))) continue;
+
+        put_param(params, attr_off[bit]);
+
+        // shared "off" parameter clears a sibling too, turn it on again
+        for (unsigned int sibling = 0; sibling < SGR_ATTRS; ++sibling)
+        {
+            if (sibling != bit && attr_off[sibling] == attr_off[bit])
+            {
+                removed &= ~(1 << sibling);
+                if (to->attrs & (1 << sibling)) added |= 1 << sibling;
+            }
+        }
+    }
+
+    for (unsigned int bit = 0; bit < SGR_ATTRS; ++bit)
+    {
+        if (added & (1 << bit)) put_param(params, attr_on[bit]);
+    }
+
+    if (from->fg != to->fg) put_color(params, to->fg, false);
+    if (from->bg != to->bg) put_color(params, to->bg, true);
+}
+
+static void put_param(params_t *const params, unsigned int value)
+{
+    char digits[4];
+    size_t i = sizeof(digits);
+    do
+    {
+        digits[--i] = '0' + value % 10;
+        value /= 10;
+    }
+    while (value);
+
+    if (params->size) params->data[params->size++] = ';';
+    memcpy(params->data + params->size, digits + i, sizeof(digits) - i);
+    params->size += sizeof(digits) - i;
+}
+
+static void put_color(params_t *const params, sgr_color_t color, bool background)
+{
+    const unsigned int base = background ? 40 : 30;
+    const unsigned int value = color & 0xffffff;
+
+    switch (SGR_COLOR_KIND(color))
+    {
+        case 1:
+            put_param(params, value < 8 ? base + value : base + 60 + value - 8);
+        break;
+        case 2:
+            put_param(params, base + 8);
+            put_param(params, 5);
+            put_param(params, value);
+        break;
+        case 3:
+            put_param(params, base + 8);
+            put_param(params, 2);
+            put_param(params, (value >> 16) & 0xff);
+            put_param(params, (value >> 8) & 0xff);
+            put_param(params, value & 0xff);
+        break;
+        default:
+            put_param(params, base + 9);
+    }
+}
+
+/* parses `5;n` or `2;r;g;b` that follows 38/48 */
+static sgr_color_t parse_extended_color(const char **seq)
+{
+    unsigned int kind, r, g, b;
+    if (**seq != ';') return SGR_COLOR_DEFAULT;
+    ++*seq;
+    if (!parse_uint(seq, &kind)) return SGR_COLOR_DEFAULT;
+
+    if (kind == 5 && **seq == ';')
+    {
+        ++*seq;
+        if (parse_uint(seq, &r)) return SGR_COLOR_INDEX(r & 0xff);
+    }
+    else if (kind == 2 && **seq == ';')
+    {
+        ++*seq;
+        if (parse_uint(seq, &r) && **seq == ';' && (++*seq, parse_uint(seq, &g))
+            && **seq == ';' && (++*seq, parse_uint(seq, &b)))
+        {
+            return SGR_COLOR_RGB(r & 0xff, g & 0xff, b & 0xff);
+        }
+    }
+    return SGR_COLOR_DEFAULT;
+}
+
+static bool parse_uint(const char **seq, unsigned int *value)
+{
+    char *end;
+    unsigned long parsed = strtoul(*seq, &end, 10);
+    if (end == *seq) return false;
+    *seq = end;
+    *value = parsed;
+    return true;
+}
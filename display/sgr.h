@@ -0,0 +1,61 @@
+#ifndef _SGR_H_
+#define _SGR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest sequence `sgr_transition` can produce */
+#define SGR_MAX_SEQ 64
+
+typedef enum
+{
+    SGR_BOLD        = 1 << 0, /* 1 */
+    SGR_DIM         = 1 << 1, /* 2 */
+    SGR_ITALIC      = 1 << 2, /* 3 */
+    SGR_UNDERLINE   = 1 << 3, /* 4 */
+    SGR_BLINK       = 1 << 4, /* 5 */
+    SGR_RAPID_BLINK = 1 << 5, /* 6 */
+    SGR_REVERSE     = 1 << 6, /* 7 */
+    SGR_HIDDEN      = 1 << 7, /* 8 */
+    SGR_STRIKE      = 1 << 8, /* 9 */
+}
+sgr_attr_t;
+
+/* Color is a kind in the high byte and a value in the lower ones */
+typedef uint32_t sgr_color_t;
+#define SGR_COLOR_DEFAULT        0
+#define SGR_COLOR_BASIC(n)       ((1u << 24) | (n)) /* 0..15  -> 30..37, 90..97 */
+#define SGR_COLOR_INDEX(n)       ((2u << 24) | (n)) /* 0..255 -> 38;5;n         */
+#define SGR_COLOR_RGB(r, g, b)   ((3u << 24) | (r) << 16 | (g) << 8 | (b))
+#define SGR_COLOR_KIND(color)    ((color) >> 24)
+
+/* Terminal graphic rendition state */
+typedef struct
+{
+    sgr_color_t fg;
+    sgr_color_t bg;
+    uint16_t attrs; /* set of sgr_attr_t */
+}
+sgr_state_t;
+
+/* Applies SGR sequences found in `seq` on top of the default state */
+sgr_state_t sgr_parse(const char *seq);
+
+/*
+ * Applies parameters of a single SGR sequence, without `ESC [`, on top of `state`.
+ * Returns pointer past the last parameter parsed.
+ */
+const char *sgr_apply(sgr_state_t *const state, const char *params);
+
+int sgr_equal(const sgr_state_t *const a, const sgr_state_t *const b);
+
+/*
+ * Writes the shortest sequence that brings terminal from `from` into `to`
+ * state, resetting only when it is cheaper than changing parameters.
+ * Returns amount of bytes written, 0 when states are equal.
+ */
+size_t sgr_transition(const sgr_state_t *const from,
+        const sgr_state_t *const to,
+        char out[static SGR_MAX_SEQ]);
+
+#endif//_SGR_H_
@@ -0,0 +1,72 @@
+#include "stats.h"
+
+#include <stdlib.h>
+
+static size_t bucket_of(uint64_t value);
+static int compare_values(const void *a, const void *b);
+
+size_t stats_record(stats_t *const stats, const frame_stats_t *const frame)
+{
+    stats->frames[stats->next] = *frame;
+    stats->next = (stats->next + 1) % STATS_WINDOW;
+    return stats->count++;
+}
+
+void stats_set(stats_t *const stats, size_t frame, stat_metric_t metric, uint64_t value)
+{
+    const size_t age = stats->count - 1 - frame;
+    if (frame >= stats->count || age >= STATS_WINDOW) return;
+    stats->frames[(stats->next + STATS_WINDOW - 1 - age) % STATS_WINDOW].values[metric] = value;
+}
+
+const frame_stats_t *stats_frame(const stats_t *const stats, size_t age)
+{
+    if (age >= stats->count || age >= STATS_WINDOW) return NULL;
+    return &stats->frames[(stats->next + STATS_WINDOW - 1 - age) % STATS_WINDOW];
+}
+
+stats_histogram_t stats_histogram(const stats_t *const stats, stat_metric_t metric)
+{
+    stats_histogram_t histogram = {0};
+    uint64_t values[STATS_WINDOW];
+    uint64_t sum = 0;
+
+    const frame_stats_t *frame;
+    for (size_t age = 0; (frame = stats_frame(stats, age)); ++age)
+    {
+        values[histogram.frames++] = frame->values[metric];
+        sum += frame->values[metric];
+        ++histogram.buckets[bucket_of(frame->values[metric])];
+    }
+    if (0 == histogram.frames) return histogram;
+
+    // window is small, sorting it gives exact percentiles
+    const size_t n = histogram.frames;
+    qsort(values, n, sizeof(*values), compare_values);
+    histogram.min = values[0];
+    histogram.max = values[n - 1];
+    histogram.mean = sum / n;
+    histogram.p50 = values[(n - 1) * 50 / 100];
+    histogram.p90 = values[(n - 1) * 90 / 100];
+    histogram.p99 = values[(n - 1) * 99 / 100];
+    return histogram;
+}
+
+/* Number of significant bits, so buckets grow by powers of two */
+static size_t bucket_of(uint64_t value)
+{
+    size_t bucket = 0;
+    while (value && bucket + 1 < STATS_BUCKETS)
+    {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+static int compare_values(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *) a;
+    const uint64_t y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
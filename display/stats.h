@@ -0,0 +1,82 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include "encoder.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATS_WINDOW  128 /* frames kept for histograms                 */
+#define STATS_BUCKETS 64  /* bucket i holds values of i significant bits */
+
+typedef enum
+{
+    STAT_CELLS_SCANNED, /* cells compared against the screen mirror */
+    STAT_CELLS_CHANGED, /* cells that differed and were sent        */
+    STAT_BYTES,         /* bytes of the encoded frame               */
+    STAT_SEQUENCES,     /* escape sequences of all kinds            */
+    STAT_ENCODE_NS,     /* time spent diffing and encoding          */
+    STAT_WRITE_NS,      /* time spent writing, 0 until it is done   */
+    STAT_METRICS
+}
+stat_metric_t;
+
+/* Counters of one rendered frame */
+typedef struct
+{
+    uint64_t values[STAT_METRICS];
+    size_t   sequences[ENCODER_SEQ_KINDS]; /* by encoder_seq_t */
+}
+frame_stats_t;
+
+/* Distribution of a metric over the frames in the window */
+typedef struct
+{
+    size_t   frames;
+    uint64_t min;
+    uint64_t max;
+    uint64_t mean;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    size_t   buckets[STATS_BUCKETS];
+}
+stats_histogram_t;
+
+/*
+ * Ring of the last STATS_WINDOW frames.
+ * Zero initialized stats are valid and empty.
+ */
+typedef struct
+{
+    frame_stats_t frames[STATS_WINDOW];
+    size_t        next;  /* slot the next frame goes to */
+    size_t        count; /* frames recorded since init  */
+}
+stats_t;
+
+/* Adds the frame to the window, returns its number for `stats_set` */
+size_t
+stats_record(stats_t *const stats,
+        const frame_stats_t *const frame);
+
+/*
+ * Updates a metric known only later, like write time, of the frame numbered `frame`.
+ * Ignored once the frame left the window.
+ */
+void
+stats_set(stats_t *const stats,
+        size_t frame,
+        stat_metric_t metric,
+        uint64_t value);
+
+/* Frame recorded `age` frames ago, 0 is the latest, NULL when out of window */
+const frame_stats_t *
+stats_frame(const stats_t *const stats,
+        size_t age);
+
+stats_histogram_t
+stats_histogram(const stats_t *const stats,
+        stat_metric_t metric);
+
+#endif//_STATS_H_
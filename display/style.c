@@ -0,0 +1,108 @@
+#include "style.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STYLE_INITIAL_CAP 64
+
+static const style_t default_style = {0};
+
+static size_t style_hash(const style_t *const style);
+static void grow(style_table_t *const table);
+static void init_default(style_table_t *const table);
+
+void style_table_deinit(style_table_t *const table)
+{
+    free(table->styles);
+    free(table->slots);
+    *table = (style_table_t){0};
+}
+
+style_id_t style_table_intern(style_table_t *const table, const style_t *const style)
+{
+    if (sgr_equal(style, &table->last)) return table->last_id;
+    if (sgr_equal(style, &default_style)) return STYLE_DEFAULT_ID;
+
+    if (!table->styles) init_default(table);
+
+    const size_t mask = table->capacity * 2 - 1; // slots are twice the capacity
+    size_t slot = style_hash(style) & mask;
+    for (; table->slots[slot]; slot = (slot + 1) & mask)
+    {
+        style_id_t id = table->slots[slot] - 1;
+        if (sgr_equal(style, &table->styles[id]))
+        {
+            table->last = *style;
+            table->last_id = id;
+            return id;
+        }
+    }
+
+    if (table->count == STYLE_MAX_COUNT) return STYLE_DEFAULT_ID;
+
+    if (table->count == table->capacity)
+    {
+        grow(table);
+        return style_table_intern(table, style); // slots were rehashed
+    }
+
+    style_id_t id = table->count++;
+    table->styles[id] = *style;
+    table->slots[slot] = (uint32_t) id + 1;
+
+    table->last = *style;
+    table->last_id = id;
+    return id;
+}
+
+const style_t *style_table_get(const style_table_t *const table, style_id_t id)
+{
+    if (id >= table->count) return &default_style;
+    return &table->styles[id];
+}
+
+static size_t style_hash(const style_t *const style)
+{
+    // FNV-1a over the fields
+    const uint32_t fields[] = {style->fg, style->bg, style->attrs};
+    size_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(*fields); ++i)
+    {
+        hash ^= fields[i];
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 29);
+}
+
+static void init_default(style_table_t *const table)
+{
+    table->capacity = STYLE_INITIAL_CAP / 2;
+    grow(table);
+    table->styles[STYLE_DEFAULT_ID] = default_style;
+    table->count = 1;
+}
+
+static void grow(style_table_t *const table)
+{
+    const size_t capacity = table->capacity * 2;
+    style_t *styles = realloc(table->styles, capacity * sizeof(style_t));
+    uint32_t *slots = calloc(capacity * 2, sizeof(uint32_t));
+    if (!styles || !slots)
+    {
+        perror("style_table");
+        exit(EXIT_FAILURE);
+    }
+
+    const size_t mask = capacity * 2 - 1;
+    for (size_t id = 0; id < table->count; ++id)
+    {
+        size_t slot = style_hash(&styles[id]) & mask;
+        while (slots[slot]) slot = (slot + 1) & mask;
+        slots[slot] = (uint32_t) id + 1;
+    }
+
+    free(table->slots);
+    table->styles = styles;
+    table->slots = slots;
+    table->capacity = capacity;
+}
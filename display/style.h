@@ -0,0 +1,48 @@
+#ifndef _STYLE_H_
+#define _STYLE_H_
+
+#include "sgr.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STYLE_DEFAULT_ID 0
+#define STYLE_MAX_COUNT  (UINT16_MAX + 1)
+
+/* Structured style: foreground, background and attributes */
+typedef sgr_state_t style_t;
+
+/* Index of the interned style, fits into a packed cell */
+typedef uint16_t style_id_t;
+
+/*
+ * Interns styles so equal styles share the same id.
+ * Zero initialized table is valid and holds only the default style.
+ */
+typedef struct
+{
+    style_t    *styles; /* id -> style                          */
+    uint32_t   *slots;  /* open addressing: id + 1, 0 for empty */
+    size_t      count;
+    size_t      capacity;
+
+    style_t     last;    /* cache of the last interned style */
+    style_id_t  last_id;
+}
+style_table_t;
+
+void style_table_deinit(style_table_t *const table);
+
+/*
+ * Returns id of the style, adding it to the table when not present.
+ * Falls back to the default style when table is full.
+ */
+style_id_t
+style_table_intern(style_table_t *const table,
+        const style_t *const style);
+
+const style_t *
+style_table_get(const style_table_t *const table,
+        style_id_t id);
+
+#endif//_STYLE_H_
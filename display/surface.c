@@ -0,0 +1,81 @@
+#include "surface.h"
+#include "text.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void surface_resize(surface_t *const surface, disp_pos_t size)
+{
+    const size_t cells = (size_t) size.x * size.y;
+    if (cells != (size_t) surface->size.x * surface->size.y)
+    {
+        disp_char_t *resized = realloc(surface->cells, (cells ? cells : 1) * sizeof(disp_char_t));
+        if (!resized)
+        {
+            perror("surface_resize");
+            exit(EXIT_FAILURE);
+        }
+        surface->cells = resized;
+    }
+    surface->size = size;
+    for (size_t i = 0; i < cells; ++i) surface->cells[i] = BLANK_CELL;
+}
+
+void surface_deinit(surface_t *const surface)
+{
+    free(surface->cells);
+    *surface = (surface_t){0};
+}
+
+disp_char_t *surface_row(const surface_t *const surface, unsigned int line)
+{
+    return &surface->cells[(size_t) line * surface->size.x];
+}
+
+void surface_set(surface_t *const surface, disp_char_t cell, disp_pos_t pos)
+{
+    if (pos.x >= surface->size.x || pos.y >= surface->size.y) return;
+    surface_row(surface, pos.y)[pos.x] = cell;
+}
+
+void surface_fill(surface_t *const surface, disp_char_t cell, disp_area_t area)
+{
+    if (!surface_clip(surface, &area)) return;
+    for (unsigned int line = area.first.y; line <= area.second.y; ++line)
+    {
+        disp_char_t *const row = surface_row(surface, line);
+        for (unsigned int col = area.first.x; col <= area.second.x; ++col) row[col] = cell;
+    }
+}
+
+void surface_draw_border(surface_t *const surface, style_id_t style, border_set_t border, disp_area_t area)
+{
+    const disp_pos_t first = area.first;
+    const disp_pos_t second = area.second;
+    const disp_char_t horizontal = {.ch = border.horizontal, .style = style};
+    const disp_char_t vertical = {.ch = border.vertical, .style = style};
+
+    surface_fill(surface, horizontal, (disp_area_t){{first.x, first.y}, {second.x, first.y}});
+    surface_fill(surface, horizontal, (disp_area_t){{first.x, second.y}, {second.x, second.y}});
+    surface_fill(surface, vertical, (disp_area_t){{first.x, first.y}, {first.x, second.y}});
+    surface_fill(surface, vertical, (disp_area_t){{second.x, first.y}, {second.x, second.y}});
+
+    surface_set(surface, (disp_char_t){.ch = border.top_left, .style = style}, first);
+    surface_set(surface, (disp_char_t){.ch = border.top_right, .style = style}, (disp_pos_t){second.x, first.y});
+    surface_set(surface, (disp_char_t){.ch = border.bot_right, .style = style}, second);
+    surface_set(surface, (disp_char_t){.ch = border.bot_left, .style = style}, (disp_pos_t){first.x, second.y});
+}
+
+void surface_draw_string(surface_t *const surface, unsigned int size, const char string[size], disp_pos_t pos, style_id_t style, cluster_table_t *const clusters)
+{
+    if (pos.x >= surface->size.x || pos.y >= surface->size.y) return;
+    (void) text_put(&surface_row(surface, pos.y)[pos.x], 0, surface->size.x - pos.x, string, size, style, clusters);
+}
+
+bool surface_clip(const surface_t *const surface, disp_area_t *const area)
+{
+    if (0 == surface->size.x || 0 == surface->size.y) return false;
+    if (area->second.x >= surface->size.x) area->second.x = surface->size.x - 1;
+    if (area->second.y >= surface->size.y) area->second.y = surface->size.y - 1;
+    return area->first.x <= area->second.x && area->first.y <= area->second.y;
+}
@@ -0,0 +1,78 @@
+#ifndef _SURFACE_H_
+#define _SURFACE_H_
+
+#include "display_types.h"
+#include "border.h"
+#include "cluster.h"
+#include "style.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Packed cell, rows of cells can be compared as flat integer arrays */
+typedef struct
+{
+    uint32_t   ch;    /* unicode codepoint or cluster id */
+    style_id_t style; /* id in the display's styles      */
+    uint16_t   flags; /* CELL_ flags                     */
+}
+disp_char_t;
+_Static_assert(sizeof(disp_char_t) == sizeof(uint64_t), "cell must stay packed");
+
+/* Cell flags */
+#define CELL_WIDE         0x1 /* glyph covers this and the next cell */
+#define CELL_CONTINUATION 0x2 /* right half of a wide glyph, ch is 0 */
+#define CELL_CLUSTER      0x4 /* ch is an id in the display's clusters */
+
+#define BLANK_CELL ((disp_char_t){.ch = U' ', .style = STYLE_DEFAULT_ID})
+
+/*
+ * Offscreen grid of cells, drawn once and copied to the display with `display_blit`.
+ * Style and cluster ids refer to the tables of the display the surface is blitted to.
+ * Zero initialized surface is valid and empty.
+ */
+typedef struct
+{
+    disp_char_t *cells;
+    disp_pos_t   size;
+}
+surface_t;
+
+/* Reallocates cells for `size`, content is blanked */
+void
+surface_resize(surface_t *const surface,
+        disp_pos_t size);
+void surface_deinit(surface_t *const surface);
+
+disp_char_t *
+surface_row(const surface_t *const surface,
+        unsigned int line);
+
+void
+surface_set(surface_t *const surface,
+        disp_char_t cell,
+        disp_pos_t pos);
+void
+surface_fill(surface_t *const surface,
+        disp_char_t cell,
+        disp_area_t area);
+void
+surface_draw_border(surface_t *const surface,
+        style_id_t style,
+        border_set_t border,
+        disp_area_t area);
+/* Draws UTF-8 string at `pos`, glyphs outside of the surface are skipped */
+void
+surface_draw_string(surface_t *const surface,
+        unsigned int size,
+        const char string[size],
+        disp_pos_t pos,
+        style_id_t style,
+        cluster_table_t *const clusters);
+
+/* Clips `area` to the surface, returns false when nothing is left */
+bool
+surface_clip(const surface_t *const surface,
+        disp_area_t *const area);
+
+#endif//_SURFACE_H_
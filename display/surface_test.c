@@ -0,0 +1,89 @@
+#include "display.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define COLS 200
+#define ROWS 60
+#define ROUNDS 2000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool same_cells(const display_t *const a, const display_t *const b)
+{
+    const size_t cells = (size_t) a->size.x * a->size.y;
+    return 0 == memcmp(a->buffers[a->active], b->buffers[b->active], cells * sizeof(disp_char_t));
+}
+
+int main(void)
+{
+    const border_set_t border = {._ = L"╭╮╯╰│─"};
+    const disp_area_t area = {{10, 5}, {COLS - 11, ROWS - 6}};
+    const disp_pos_t size = {area.second.x - area.first.x + 1, area.second.y - area.first.y + 1};
+
+    display_t drawn = {0}, blitted = {0};
+    display_resize(&drawn, (disp_pos_t){COLS, ROWS});
+    display_resize(&blitted, (disp_pos_t){COLS, ROWS});
+
+    // surface drawn once gives the same cells as drawing straight into the display
+    surface_t surface = {0};
+    surface_resize(&surface, size);
+    const style_id_t style = display_intern_style(&blitted, BORDER_STYLE_2);
+    surface_draw_border(&surface, style, border, (disp_area_t){{0, 0}, {size.x - 1, size.y - 1}});
+    surface_draw_string(&surface, 5, "title", (disp_pos_t){2, 0}, style, &blitted.clusters);
+
+    display_draw_border(&drawn, BORDER_STYLE_2, border, area);
+    display_draw_string(&drawn, 5, "title", (disp_pos_t){area.first.x + 2, area.first.y}, BORDER_STYLE_2);
+    display_blit(&blitted, &surface, (disp_area_t){{0, 0}, {size.x - 1, size.y - 1}}, area.first);
+    assert(same_cells(&drawn, &blitted));
+
+    // blit is clipped by the display, cells beyond its edges are skipped
+    display_clear(&blitted);
+    display_blit(&blitted, &surface, (disp_area_t){{0, 0}, {UINT16_MAX, UINT16_MAX}}, (disp_pos_t){COLS - 3, ROWS - 2});
+    assert(blitted.buffers[blitted.active][(ROWS - 2) * COLS + COLS - 3].ch == U'╭');
+    assert(blitted.buffers[blitted.active][(ROWS - 1) * COLS + COLS - 3].ch == U'│');
+    assert(blitted.buffers[blitted.active][(ROWS - 2) * COLS + COLS - 1].ch == U't');
+
+    // clip moves the origin and cuts drawing, blit included
+    display_clear(&blitted);
+    assert(display_push_clip(&blitted, (disp_rect_t){-2, 0, 6, 4}));
+    display_blit(&blitted, &surface, (disp_area_t){{0, 0}, {UINT16_MAX, UINT16_MAX}}, (disp_pos_t){0, 0});
+    assert(blitted.buffers[blitted.active][0].ch == U't');
+    assert(blitted.buffers[blitted.active][3].ch == U'l');
+    assert(blitted.buffers[blitted.active][4].ch == U' ');
+    assert(blitted.buffers[blitted.active][COLS].ch == U' ');
+    assert(!display_push_clip(&blitted, (disp_rect_t){10, 0, 5, 5}));
+    display_draw_string(&blitted, 5, "title", (disp_pos_t){0, 0}, BORDER_STYLE_1);
+    display_pop_clip(&blitted);
+    display_pop_clip(&blitted);
+    assert(0 == blitted.clip_depth);
+
+    // unchanged content costs a compare per row
+    double start = now();
+    for (int i = 0; i < ROUNDS; ++i)
+    {
+        display_draw_border(&drawn, BORDER_STYLE_2, border, area);
+    }
+    const double draw = (now() - start) / ROUNDS;
+
+    start = now();
+    for (int i = 0; i < ROUNDS; ++i)
+    {
+        display_blit(&blitted, &surface, (disp_area_t){{0, 0}, {size.x - 1, size.y - 1}}, area.first);
+    }
+    const double blit = (now() - start) / ROUNDS;
+
+    printf("%ux%u border: draw %.2f us, blit %.2f us\n", size.x, size.y, draw * 1e6, blit * 1e6);
+
+    surface_deinit(&surface);
+    display_deinit(&drawn);
+    display_deinit(&blitted);
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "termcaps.h"
+
+#include <errno.h>
+#include <langinfo.h>
+#include <poll.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ESC "\x1b"
+
+#define QUERY_SYNC_OUTPUT ESC "[?2026$p"
+#define QUERY_DA1         ESC "[c"
+
+#define REPLY_MAX TERMCAPS_READ_MAX
+
+static const struct
+{
+    const char *name;
+    size_t offset;
+}
+overrides[] = {
+    {"TIFC_SYNC_OUTPUT", offsetof(term_caps_t, sync_output)},
+    {"TIFC_REP",         offsetof(term_caps_t, rep)},
+    {"TIFC_ECH",         offsetof(term_caps_t, ech)},
+    {"TIFC_BCE",         offsetof(term_caps_t, bce)},
+};
+
+/* TERM prefixes of terminals known to implement REP */
+static const char *const rep_terms[] = {
+    "xterm", "foot", "alacritty", "wezterm", "tmux", "contour", "ghostty",
+};
+
+static bool query_sync_output(int in_fd, int out_fd, int timeout_ms, termcaps_typed_t *const typed);
+static void guess_by_term(term_caps_t *const caps, const char *const term);
+static bool has_prefix(const char *const string, const char *const prefix);
+static int env_override(const char *const name);
+static int elapsed_ms(const struct timespec *const since);
+static bool is_da1_reply(const char *const reply, size_t size);
+static int mode_status(const char *const reply, const char *const mode);
+static size_t split_replies(char *const reply, size_t size, termcaps_typed_t *const typed);
+
+term_caps_t termcaps_query(int in_fd, int out_fd, int timeout_ms, termcaps_typed_t *const typed)
+{
+    typed->size = 0;
+    term_caps_t caps = {0};
+    guess_by_term(&caps, getenv("TERM"));
+    caps.legacy_charset = 0 != strcmp(nl_langinfo(CODESET), "UTF-8");
+
+    // skip the round trip when the answer is forced anyway
+    if (-1 == env_override("TIFC_SYNC_OUTPUT"))
+    {
+        caps.sync_output = query_sync_output(in_fd, out_fd, timeout_ms, typed);
+    }
+
+    for (size_t i = 0; i < sizeof(overrides) / sizeof(*overrides); ++i)
+    {
+        const int forced = env_override(overrides[i].name);
+        if (-1 != forced) *(bool *) ((char *) &caps + overrides[i].offset) = forced;
+    }
+    return caps;
+}
+
+static bool query_sync_output(int in_fd, int out_fd, int timeout_ms, termcaps_typed_t *const typed)
+{
+    if (!isatty(in_fd) || !isatty(out_fd)) return false;
+
+    const char query[] = QUERY_SYNC_OUTPUT QUERY_DA1;
+    if ((ssize_t) sizeof(query) - 1 != write(out_fd, query, sizeof(query) - 1))
+    {
+        return false;
+    }
+
+    // byte by byte, so input typed after the replies stays in the queue,
+    // input typed in between is separated from the replies afterwards
+    char reply[REPLY_MAX + 1];
+    size_t size = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (size < REPLY_MAX && !is_da1_reply(reply, size))
+    {
+        const int left = timeout_ms - elapsed_ms(&start);
+        if (left <= 0) break;
+
+        struct pollfd pfd = {.fd = in_fd, .events = POLLIN};
+        const int ready = poll(&pfd, 1, left);
+        if (-1 == ready && EINTR == errno) continue;
+        if (ready <= 0) break;
+
+        if (1 != read(in_fd, reply + size, 1)) break;
+        ++size;
+    }
+    size = split_replies(reply, size, typed);
+    reply[size] = '\0';
+
+    // DECRPM: 1 - set, 2 - reset, both mean the mode is recognized
+    const int status = mode_status(reply, "2026");
+    return 1 == status || 2 == status;
+}
+
+static void guess_by_term(term_caps_t *const caps, const char *const term)
+{
+    if (!term || !*term || 0 == strcmp(term, "dumb")) return;
+
+    for (size_t i = 0; i < sizeof(rep_terms) / sizeof(*rep_terms); ++i)
+    {
+        if (has_prefix(term, rep_terms[i])) caps->rep = true;
+    }
+    // ECH came with VT220, everything emulating less is rare these days
+    caps->ech = !has_prefix(term, "vt100") && !has_prefix(term, "vt52");
+    caps->bce = !has_prefix(term, "screen");
+}
+
+static bool has_prefix(const char *const string, const char *const prefix)
+{
+    return 0 == strncmp(string, prefix, strlen(prefix));
+}
+
+static int env_override(const char *const name)
+{
+    const char *value = getenv(name);
+    if (!value || !*value) return -1;
+    return 0 != strcmp(value, "0");
+}
+
+static int elapsed_ms(const struct timespec *const since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000
+        + (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+static bool is_da1_reply(const char *const reply, size_t size)
+{
+    // ESC [ ? <params> c
+    if (0 == size || 'c' != reply[size - 1]) return false;
+    for (size_t i = size - 1; i-- > 0;)
+    {
+        const char ch = reply[i];
+        if ('?' == ch) return i >= 2 && 0 == memcmp(reply + i - 2, ESC "[", 2);
+        if (!(ch >= '0' && ch <= '9') && ';' != ch) return false;
+    }
+    return false;
+}
+
+static int mode_status(const char *const reply, const char *const mode)
+{
+    // ESC [ ? <mode> ; <status> $ y
+    char prefix[16] = ESC "[?";
+    strncat(prefix, mode, sizeof(prefix) - strlen(prefix) - 2);
+    strcat(prefix, ";");
+
+    const char *found = strstr(reply, prefix);
+    if (!found) return 0;
+
+    char *end;
+    const long status = strtol(found + strlen(prefix), &end, 10);
+    if (0 != strncmp(end, "$y", 2)) return 0;
+    return (int) status;
+}
+
+/* Moves bytes which are not ESC [ ? replies to `typed`, returns size of the replies left */
+static size_t split_replies(char *const reply, size_t size, termcaps_typed_t *const typed)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < size;)
+    {
+        if (size - i < 3 || 0 != memcmp(reply + i, ESC "[?", 3))
+        {
+            typed->bytes[typed->size++] = reply[i++];
+            continue;
+        }
+        // parameters and intermediates up to the final byte, a cut reply is dropped
+        size_t end = i + 3;
+        while (end < size && reply[end] >= 0x20 && reply[end] <= 0x3f) ++end;
+        if (end < size) ++end;
+        memmove(reply + kept, reply + i, end - i);
+        kept += end - i;
+        i = end;
+    }
+    return kept;
+}
@@ -0,0 +1,44 @@
+#ifndef _TERMCAPS_H_
+#define _TERMCAPS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TERMCAPS_TIMEOUT_MS 100
+#define TERMCAPS_READ_MAX   256 /* bytes read while waiting for the replies */
+
+#define SYNC_OUTPUT_BEGIN "\x1b[?2026h"
+#define SYNC_OUTPUT_END   "\x1b[?2026l"
+
+/* Optional features of the terminal, all off when zero initialized */
+typedef struct
+{
+    bool sync_output;    /* mode 2026, frame is applied atomically      */
+    bool rep;            /* REP repeats the preceding character         */
+    bool ech;            /* ECH erases characters without moving cursor */
+    bool bce;            /* erased cells take the current background    */
+    bool legacy_charset; /* locale is not UTF-8, encode through libc    */
+}
+term_caps_t;
+
+/* Input typed while the replies were awaited, it belongs to the application */
+typedef struct
+{
+    char   bytes[TERMCAPS_READ_MAX];
+    size_t size;
+}
+termcaps_typed_t;
+
+/*
+ * Asks terminal on `out_fd` about supported features and reads replies from `in_fd`.
+ * Queries are followed by DA1, which every terminal answers,
+ * so unsupported features are known without waiting for the whole timeout.
+ * Terminal has to be in non canonical mode without echo.
+ * Features without a query are guessed by TERM.
+ * Environment variables TIFC_SYNC_OUTPUT, TIFC_REP, TIFC_ECH and TIFC_BCE
+ * set to 0 or 1 override the detection.
+ * Bytes read from `in_fd` which are not replies are handed over in `typed`.
+ */
+term_caps_t termcaps_query(int in_fd, int out_fd, int timeout_ms, termcaps_typed_t *const typed);
+
+#endif//_TERMCAPS_H_
@@ -0,0 +1,174 @@
+#include "text.h"
+#include "utf8.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static unsigned int decode_width(const char *const string, size_t size, size_t *const bytes, uint32_t *const cp);
+static bool is_control(uint32_t cp);
+
+size_t text_ascii_prefix(const char *const string, size_t size)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    for (; i + 16 <= size; i += 16)
+    {
+        // bytes past 0x7f are negative, one signed compare catches them with controls
+        const __m128i bytes = _mm_loadu_si128((const __m128i *) (string + i));
+        const __m128i other = _mm_or_si128(_mm_cmplt_epi8(bytes, space), _mm_cmpeq_epi8(bytes, del));
+        const int mask = _mm_movemask_epi8(other);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+#endif
+    const unsigned char *const s = (const unsigned char *) string;
+    while (i < size && s[i] >= 0x20 && s[i] < 0x7f) ++i;
+    return i;
+}
+
+unsigned int text_width(const char *const string, size_t size)
+{
+    unsigned int width = 0;
+    size_t i = 0;
+    while (i < size)
+    {
+        const size_t ascii = text_ascii_prefix(string + i, size - i);
+        width += ascii;
+        i += ascii;
+        if (i == size) break;
+
+        size_t bytes;
+        uint32_t cp;
+        width += decode_width(string + i, size - i, &bytes, &cp);
+        i += bytes;
+    }
+    return width;
+}
+
+size_t text_fit(const char *const string, size_t size, unsigned int width, text_overflow_t overflow, bool *const ellipsis)
+{
+    // prefix which leaves room for the ellipsis is tracked along the way
+    const unsigned int limit = (TEXT_ELLIPSIZE == overflow && width) ? width - 1 : width;
+    unsigned int col = 0;
+    size_t i = 0, marked = 0;
+
+    *ellipsis = false;
+    while (i < size)
+    {
+        const size_t ascii = text_ascii_prefix(string + i, size - i);
+        if (ascii)
+        {
+            const size_t room = width - col;
+            const size_t taken = ascii < room ? ascii : room;
+            i += taken;
+            col += taken;
+            if (col <= limit) marked = i;
+            else if (col - taken < limit) marked = i - (col - limit);
+            if (taken < ascii) break;
+            continue;
+        }
+
+        size_t bytes;
+        uint32_t cp;
+        const unsigned int glyph = decode_width(string + i, size - i, &bytes, &cp);
+        if (col + glyph > width) break;
+        col += glyph;
+        i += bytes;
+        if (col <= limit) marked = i;
+    }
+
+    if (i == size) return size;
+    if (TEXT_ELLIPSIZE != overflow || 0 == width) return i;
+    *ellipsis = true;
+    return marked;
+}
+
+unsigned int text_put(disp_char_t *const cells, unsigned int skip, unsigned int columns,
+        const char *const string, size_t size, style_id_t style, cluster_table_t *const clusters)
+{
+    const unsigned char *const s = (const unsigned char *) string;
+    const unsigned int end = skip + columns;
+    unsigned int col = 0;
+    size_t i = 0;
+    disp_char_t *glyph_cell = NULL; // last glyph written, marks join it
+
+    while (i < size && col < end)
+    {
+        // printable ASCII maps byte to cell, no decoding needed
+        size_t ascii = text_ascii_prefix(string + i, size - i);
+        if (ascii)
+        {
+            if (ascii > end - col) ascii = end - col;
+            const unsigned int from = col < skip ? skip - col : 0;
+            for (size_t k = from; k < ascii; ++k)
+            {
+                cells[col + k - skip] = (disp_char_t){.ch = s[i + k], .style = style};
+            }
+            glyph_cell = from < ascii ? &cells[col + ascii - 1 - skip] : NULL;
+            i += ascii;
+            col += ascii;
+            continue;
+        }
+
+        size_t bytes;
+        uint32_t cp;
+        const unsigned int glyph = decode_width(string + i, size - i, &bytes, &cp);
+        i += bytes;
+        if (0 == glyph)
+        {
+            if (glyph_cell && clusters && !is_control(cp)) text_combine(glyph_cell, cp, clusters);
+            continue;
+        }
+
+        if (col >= skip && col + glyph <= end)
+        {
+            if (1 == glyph)
+            {
+                cells[col - skip] = (disp_char_t){.ch = cp, .style = style};
+            }
+            else
+            {
+                cells[col - skip] = (disp_char_t){.ch = cp, .style = style, .flags = CELL_WIDE};
+                cells[col - skip + 1] = (disp_char_t){.ch = 0, .style = style, .flags = CELL_CONTINUATION};
+            }
+            glyph_cell = &cells[col - skip];
+        }
+        else
+        {
+            // half of a wide glyph can not be shown
+            glyph_cell = NULL;
+            for (unsigned int c = col; c < col + glyph; ++c)
+            {
+                if (c >= skip && c < end) cells[c - skip] = (disp_char_t){.ch = U' ', .style = style};
+            }
+        }
+        col += glyph;
+    }
+    return col < end ? col : end;
+}
+
+void text_combine(disp_char_t *const cell, uint32_t mark, cluster_table_t *const clusters)
+{
+    cluster_t cluster = {.base = cell->ch};
+    if (cell->flags & CELL_CLUSTER) cluster = *cluster_table_get(clusters, cell->ch);
+    if (CLUSTER_MAX_MARKS == cluster.count) return;
+    cluster.marks[cluster.count++] = mark;
+
+    const uint32_t id = cluster_table_intern(clusters, &cluster);
+    if (CLUSTER_NONE == id) return; // table is full, mark is dropped
+    cell->ch = id;
+    cell->flags |= CELL_CLUSTER;
+}
+
+static unsigned int decode_width(const char *const string, size_t size, size_t *const bytes, uint32_t *const cp)
+{
+    *bytes = utf8_decode(string, size, cp);
+    return glyph_width(*cp);
+}
+
+static bool is_control(uint32_t cp)
+{
+    return cp < 0x20 || (cp >= 0x7f && cp < 0xa0);
+}
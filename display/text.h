@@ -0,0 +1,65 @@
+#ifndef _TEXT_H_
+#define _TEXT_H_
+
+#include "glyph_width.h"
+#include "surface.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TEXT_ELLIPSIS U'…'
+
+/* What to do with text longer than its width */
+typedef enum
+{
+    TEXT_TRUNCATE, /* cut at the last column                 */
+    TEXT_ELLIPSIZE /* cut earlier and end with TEXT_ELLIPSIS */
+}
+text_overflow_t;
+
+/* Length of the leading run of printable ASCII */
+size_t
+text_ascii_prefix(const char *const string,
+        size_t size);
+
+/* Columns the UTF-8 string takes */
+unsigned int
+text_width(const char *const string,
+        size_t size);
+
+/*
+ * Returns bytes of the longest prefix that fits into `width` columns.
+ * With TEXT_ELLIPSIZE and the string cut, the prefix leaves a column
+ * for the ellipsis and `ellipsis` is set.
+ */
+size_t
+text_fit(const char *const string,
+        size_t size,
+        unsigned int width,
+        text_overflow_t overflow,
+        bool *const ellipsis);
+
+/*
+ * Lays UTF-8 string out from column 0 and writes its columns `skip..skip + columns - 1`
+ * into `cells`. Wide glyphs take a CELL_WIDE cell and a CELL_CONTINUATION cell,
+ * a glyph cut by either end leaves blanks instead.
+ * Combining marks join the glyph before them in `clusters`, without it they are dropped.
+ * Returns columns laid out, skipped ones included, at most `skip + columns`.
+ */
+unsigned int
+text_put(disp_char_t *const cells,
+        unsigned int skip,
+        unsigned int columns,
+        const char *const string,
+        size_t size,
+        style_id_t style,
+        cluster_table_t *const clusters);
+
+/* Adds combining `mark` to the glyph of the cell, turning it into a CELL_CLUSTER */
+void
+text_combine(disp_char_t *const cell,
+        uint32_t mark,
+        cluster_table_t *const clusters);
+
+#endif//_TEXT_H_
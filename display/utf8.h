@@ -0,0 +1,84 @@
+#ifndef _UTF8_H_
+#define _UTF8_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UTF8_MAX 4
+#define UTF8_REPLACEMENT 0xfffd
+
+/*
+ * Writes code point `cp` as UTF-8 into `out`, returns amount of bytes written.
+ * Surrogates and values past U+10FFFF are replaced with U+FFFD.
+ */
+static inline size_t utf8_encode(uint32_t cp, char out[UTF8_MAX])
+{
+    // first code point that needs one more byte, and lead byte marker per length
+    static const uint32_t limits[UTF8_MAX] = {0x80, 0x800, 0x10000, 0x110000};
+    static const unsigned char leads[UTF8_MAX] = {0x00, 0xc0, 0xe0, 0xf0};
+
+    if (cp < 0x80)
+    {
+        out[0] = (char) cp;
+        return 1;
+    }
+    if (cp >= limits[UTF8_MAX - 1] || (cp >= 0xd800 && cp <= 0xdfff))
+    {
+        cp = UTF8_REPLACEMENT;
+    }
+
+    size_t length = 2;
+    while (cp >= limits[length - 1]) ++length;
+
+    for (size_t i = length - 1; i > 0; --i)
+    {
+        out[i] = (char) (0x80 | (cp & 0x3f));
+        cp >>= 6;
+    }
+    out[0] = (char) (leads[length - 1] | cp);
+    return length;
+}
+
+/*
+ * Decodes one code point from `size` > 0 bytes at `in`, returns amount of bytes consumed.
+ * Malformed, overlong or truncated sequences yield U+FFFD and consume one byte.
+ */
+static inline size_t utf8_decode(const char *const in, size_t size, uint32_t *const cp)
+{
+    const unsigned char *const s = (const unsigned char *) in;
+    if (s[0] < 0x80)
+    {
+        *cp = s[0];
+        return 1;
+    }
+
+    size_t length;
+    uint32_t value, min;
+    if      (0xc0 == (s[0] & 0xe0)) { length = 2; value = s[0] & 0x1f; min = 0x80; }
+    else if (0xe0 == (s[0] & 0xf0)) { length = 3; value = s[0] & 0x0f; min = 0x800; }
+    else if (0xf0 == (s[0] & 0xf8)) { length = 4; value = s[0] & 0x07; min = 0x10000; }
+    else length = 0;
+
+    if (0 == length || length > size)
+    {
+        *cp = UTF8_REPLACEMENT;
+        return 1;
+    }
+    for (size_t i = 1; i < length; ++i)
+    {
+        if (0x80 != (s[i] & 0xc0))
+        {
+            *cp = UTF8_REPLACEMENT;
+            return 1;
+        }
+        value = (value << 6) | (s[i] & 0x3f);
+    }
+    if (value < min || value > 0x10ffff || (value >= 0xd800 && value <= 0xdfff))
+    {
+        value = UTF8_REPLACEMENT;
+    }
+    *cp = value;
+    return length;
+}
+
+#endif//_UTF8_H_
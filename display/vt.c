@@ -0,0 +1,437 @@
+#include "vt.h"
+#include "glyph_width.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ESC '\x1b'
+
+/* attributes that are visible on a blank cell */
+#define BLANK_ATTRS (SGR_UNDERLINE | SGR_REVERSE | SGR_STRIKE)
+
+static void put_byte(vt_t *const vt, unsigned char byte);
+static void control(vt_t *const vt, unsigned char byte);
+static void print(vt_t *const vt, uint32_t ch);
+static void csi(vt_t *const vt, char final);
+static void private_mode(vt_t *const vt, char final);
+static unsigned int param(const vt_t *const vt, unsigned int index, unsigned int fallback);
+static void line_feed(vt_t *const vt);
+static void scroll(vt_t *const vt, unsigned int top, unsigned int bottom, int lines);
+static void erase(vt_t *const vt, unsigned int line, unsigned int first, unsigned int last);
+static void split(vt_t *const vt, unsigned int x, unsigned int y);
+static vt_cell_t *cell_at(const vt_t *const vt, unsigned int x, unsigned int y);
+static vt_cell_t blank(const vt_t *const vt);
+static unsigned int clamp(int value, unsigned int low, unsigned int high);
+
+void vt_init(vt_t *const vt, disp_pos_t size)
+{
+    const size_t cells = (size_t) size.x * size.y;
+    *vt = (vt_t){
+        .cells = malloc((cells ? cells : 1) * sizeof(vt_cell_t)),
+        .size = size,
+        .cursor_visible = true,
+        .bottom = size.y ? size.y - 1 : 0,
+    };
+    if (!vt->cells)
+    {
+        perror("vt_init");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < cells; ++i) vt->cells[i] = blank(vt);
+}
+
+void vt_deinit(vt_t *const vt)
+{
+    free(vt->cells);
+    *vt = (vt_t){0};
+}
+
+void vt_feed(vt_t *const vt, const void *const data, size_t size)
+{
+    const unsigned char *bytes = data;
+    vt->frame.bytes += size;
+    vt->total.bytes += size;
+    for (size_t i = 0; i < size; ++i) put_byte(vt, bytes[i]);
+}
+
+vt_stats_t vt_end_frame(vt_t *const vt)
+{
+    vt_stats_t frame = vt->frame;
+    vt->frame = (vt_stats_t){0};
+    return frame;
+}
+
+const vt_cell_t *vt_cell(const vt_t *const vt, disp_pos_t pos)
+{
+    return cell_at(vt, pos.x, pos.y);
+}
+
+bool vt_cell_shows(const vt_cell_t *const cell, uint32_t ch, const sgr_state_t *const style)
+{
+    if (cell->ch != ch) return false;
+    if (U' ' != ch) return sgr_equal(&cell->style, style);
+
+    // only background and line attributes are seen on a blank, reverse shows foreground
+    const uint16_t attrs = cell->style.attrs & BLANK_ATTRS;
+    if (attrs != (style->attrs & BLANK_ATTRS)) return false;
+    if (attrs & SGR_REVERSE) return cell->style.fg == style->fg && cell->style.bg == style->bg;
+    return cell->style.bg == style->bg;
+}
+
+static void put_byte(vt_t *const vt, unsigned char byte)
+{
+    switch (vt->state)
+    {
+        case VT_GROUND:
+            if (ESC == byte)
+            {
+                vt->state = VT_ESCAPE;
+            }
+            else if (byte < 0x20 || 0x7f == byte)
+            {
+                control(vt, byte);
+            }
+            else if (byte < 0x80)
+            {
+                vt->continuation = 0;
+                print(vt, byte);
+            }
+            else if (0x80 == (byte & 0xc0) && vt->continuation)
+            {
+                vt->codepoint = (vt->codepoint << 6) | (byte & 0x3f);
+                if (0 == --vt->continuation) print(vt, vt->codepoint);
+            }
+            else
+            {
+                // lead byte tells how many continuation bytes follow
+                vt->continuation = (byte >= 0xf0) ? 3 : (byte >= 0xe0) ? 2 : 1;
+                vt->codepoint = byte & (0x3f >> vt->continuation);
+            }
+        break;
+
+        case VT_ESCAPE:
+            ++vt->frame.sequences;
+            ++vt->total.sequences;
+            if ('[' == byte)
+            {
+                vt->state = VT_CSI;
+                vt->seq_size = 0;
+                break;
+            }
+            // charset designations, keypad modes... nothing the encoder emits
+            ++vt->frame.unknown;
+            ++vt->total.unknown;
+            vt->state = VT_GROUND;
+        break;
+
+        case VT_CSI:
+            if (byte >= 0x40 && byte <= 0x7e)
+            {
+                vt->seq[vt->seq_size] = '\0';
+                vt->state = VT_GROUND;
+                csi(vt, byte);
+            }
+            else if (vt->seq_size + 1 < VT_MAX_SEQ)
+            {
+                vt->seq[vt->seq_size++] = byte;
+            }
+        break;
+    }
+}
+
+static void control(vt_t *const vt, unsigned char byte)
+{
+    ++vt->frame.controls;
+    ++vt->total.controls;
+    switch (byte)
+    {
+        case '\r':
+            vt->cursor.x = 0;
+            vt->wrap_pending = false;
+        break;
+        case '\n':
+        case '\v':
+        case '\f':
+            line_feed(vt);
+            vt->wrap_pending = false;
+        break;
+        case '\b':
+            if (vt->cursor.x > 0) --vt->cursor.x;
+            vt->wrap_pending = false;
+        break;
+        default:
+        break;
+    }
+}
+
+static void print(vt_t *const vt, uint32_t ch)
+{
+    const unsigned int width = glyph_width(ch);
+    if (0 == vt->size.x || 0 == vt->size.y) return;
+    if (0 == width)
+    {
+        // combining mark joins the glyph printed last, cursor stays
+        unsigned int x = vt->cursor.x;
+        if (!vt->wrap_pending && x > 0) --x;
+        if (0 == cell_at(vt, x, vt->cursor.y)->ch && x > 0) --x;
+        vt_cell_t *const cell = cell_at(vt, x, vt->cursor.y);
+        if (cell->mark_count < VT_MAX_MARKS) cell->marks[cell->mark_count++] = ch;
+        return;
+    }
+
+    // wide glyph which does not fit the line goes to the next one
+    if (vt->wrap_pending || vt->cursor.x + width > vt->size.x)
+    {
+        vt->cursor.x = 0;
+        line_feed(vt);
+        vt->wrap_pending = false;
+    }
+
+    // wide glyph is its cell and a continuation cell with no character
+    split(vt, vt->cursor.x, vt->cursor.y);
+    *cell_at(vt, vt->cursor.x, vt->cursor.y) = (vt_cell_t){.ch = ch, .style = vt->style};
+    if (2 == width && vt->cursor.x + 1u < vt->size.x)
+    {
+        split(vt, vt->cursor.x + 1, vt->cursor.y);
+        *cell_at(vt, vt->cursor.x + 1, vt->cursor.y) = (vt_cell_t){.ch = 0, .style = vt->style};
+    }
+    vt->last_char = ch;
+    ++vt->frame.printed;
+    ++vt->total.printed;
+
+    // cursor stays on the last column until the next character
+    if (vt->cursor.x + width >= vt->size.x)
+    {
+        vt->cursor.x = vt->size.x - 1;
+        vt->wrap_pending = true;
+    }
+    else vt->cursor.x += width;
+}
+
+static void csi(vt_t *const vt, char final)
+{
+    if ('?' == vt->seq[0])
+    {
+        private_mode(vt, final);
+        return;
+    }
+
+    const unsigned int n = param(vt, 0, 1);
+    const unsigned int max_x = vt->size.x ? vt->size.x - 1 : 0;
+    const unsigned int max_y = vt->size.y ? vt->size.y - 1 : 0;
+    disp_pos_t *const cursor = &vt->cursor;
+    bool moves = true; // most sequences cancel pending wrap
+
+    switch (final)
+    {
+        case 'A': // CUU, stops at the top margin when below it
+            cursor->y = clamp((int) cursor->y - (int) n, cursor->y >= vt->top ? vt->top : 0, max_y);
+        break;
+        case 'B': // CUD
+            cursor->y = clamp(cursor->y + n, 0, cursor->y <= vt->bottom ? vt->bottom : max_y);
+        break;
+        case 'C': // CUF
+            cursor->x = clamp(cursor->x + n, 0, max_x);
+        break;
+        case 'D': // CUB
+            cursor->x = clamp((int) cursor->x - (int) n, 0, max_x);
+        break;
+        case 'G': // CHA
+            cursor->x = clamp((int) n - 1, 0, max_x);
+        break;
+        case 'd': // VPA
+            cursor->y = clamp((int) n - 1, 0, max_y);
+        break;
+        case 'H': // CUP
+        case 'f':
+            cursor->y = clamp((int) param(vt, 0, 1) - 1, 0, max_y);
+            cursor->x = clamp((int) param(vt, 1, 1) - 1, 0, max_x);
+        break;
+        case 'J': // ED
+        {
+            const unsigned int mode = param(vt, 0, 0);
+            for (unsigned int line = 0; line < vt->size.y; ++line)
+            {
+                if ((0 == mode && line > cursor->y) || (1 == mode && line < cursor->y) || 2 == mode)
+                {
+                    erase(vt, line, 0, max_x);
+                }
+            }
+            if (0 == mode) erase(vt, cursor->y, cursor->x, max_x);
+            if (1 == mode) erase(vt, cursor->y, 0, cursor->x);
+            moves = false;
+        }
+        break;
+        case 'K': // EL
+        {
+            const unsigned int mode = param(vt, 0, 0);
+            erase(vt, cursor->y, 0 == mode ? cursor->x : 0, 1 == mode ? cursor->x : max_x);
+            moves = false;
+        }
+        break;
+        case 'X': // ECH
+            erase(vt, cursor->y, cursor->x, clamp(cursor->x + n - 1, 0, max_x));
+            moves = false;
+        break;
+        case '@': // ICH
+        case 'P': // DCH
+        {
+            vt_cell_t *const row = cell_at(vt, 0, cursor->y);
+            const unsigned int amount = clamp(n, 0, vt->size.x - cursor->x);
+            const size_t rest = vt->size.x - cursor->x - amount;
+            if ('@' == final)
+            {
+                memmove(&row[cursor->x + amount], &row[cursor->x], rest * sizeof(vt_cell_t));
+                erase(vt, cursor->y, cursor->x, cursor->x + amount - 1);
+            }
+            else
+            {
+                memmove(&row[cursor->x], &row[cursor->x + amount], rest * sizeof(vt_cell_t));
+                erase(vt, cursor->y, vt->size.x - amount, max_x);
+            }
+        }
+        break;
+        case 'S': // SU
+            scroll(vt, vt->top, vt->bottom, n);
+            moves = false;
+        break;
+        case 'T': // SD
+            scroll(vt, vt->top, vt->bottom, -(int) n);
+            moves = false;
+        break;
+        case 'L': // IL
+        case 'M': // DL
+            if (cursor->y >= vt->top && cursor->y <= vt->bottom)
+            {
+                scroll(vt, cursor->y, vt->bottom, 'L' == final ? -(int) n : (int) n);
+                cursor->x = 0;
+            }
+        break;
+        case 'b': // REP
+            for (unsigned int i = 0; i < n && vt->last_char; ++i) print(vt, vt->last_char);
+            moves = false;
+        break;
+        case 'r': // DECSTBM, homes the cursor
+        {
+            const unsigned int top = param(vt, 0, 1) - 1;
+            const unsigned int bottom = param(vt, 1, vt->size.y) - 1;
+            if (top < bottom && bottom <= max_y)
+            {
+                vt->top = top;
+                vt->bottom = bottom;
+            }
+            *cursor = (disp_pos_t){0, 0};
+        }
+        break;
+        case 'm': // SGR
+            sgr_apply(&vt->style, vt->seq);
+            moves = false;
+        break;
+        case 'c': // DA1 and mode queries are answered by a real terminal only
+        case 'p':
+            moves = false;
+        break;
+        default:
+            ++vt->frame.unknown;
+            ++vt->total.unknown;
+            moves = false;
+        break;
+    }
+    if (moves) vt->wrap_pending = false;
+}
+
+static void private_mode(vt_t *const vt, char final)
+{
+    if ('h' != final && 'l' != final) return; // DECRQM and others
+
+    const bool set = 'h' == final;
+    unsigned int index = 0;
+    for (const char *p = vt->seq; p; p = strchr(p + 1, ';'), ++index)
+    {
+        const unsigned int mode = param(vt, index, 0);
+        if (25 == mode) vt->cursor_visible = set;
+        else if (2026 == mode) vt->sync_output = set;
+    }
+}
+
+/* Numeric parameter `index` of the current sequence, `fallback` when omitted or 0 */
+static unsigned int param(const vt_t *const vt, unsigned int index, unsigned int fallback)
+{
+    const char *p = vt->seq;
+    if ('?' == *p) ++p;
+    for (unsigned int i = 0; i < index; ++i)
+    {
+        p = strchr(p, ';');
+        if (!p) return fallback;
+        ++p;
+    }
+
+    unsigned int value = 0;
+    bool present = false;
+    for (; *p >= '0' && *p <= '9'; ++p)
+    {
+        value = value * 10 + (*p - '0');
+        present = true;
+    }
+    return (present && value) ? value : fallback;
+}
+
+static void line_feed(vt_t *const vt)
+{
+    if (vt->cursor.y == vt->bottom) scroll(vt, vt->top, vt->bottom, 1);
+    else if (vt->cursor.y + 1u < vt->size.y) ++vt->cursor.y;
+}
+
+/* Moves lines `top..bottom` by `lines`, positive is up, exposed lines are blank */
+static void scroll(vt_t *const vt, unsigned int top, unsigned int bottom, int lines)
+{
+    const unsigned int height = bottom - top + 1;
+    const unsigned int amount = clamp(lines < 0 ? -lines : lines, 0, height);
+    const size_t row = vt->size.x;
+
+    if (lines > 0)
+    {
+        memmove(cell_at(vt, 0, top), cell_at(vt, 0, top + amount), (height - amount) * row * sizeof(vt_cell_t));
+        for (unsigned int line = bottom + 1 - amount; line <= bottom; ++line) erase(vt, line, 0, vt->size.x - 1);
+    }
+    else
+    {
+        memmove(cell_at(vt, 0, top + amount), cell_at(vt, 0, top), (height - amount) * row * sizeof(vt_cell_t));
+        for (unsigned int line = top; line < top + amount; ++line) erase(vt, line, 0, vt->size.x - 1);
+    }
+}
+
+static void erase(vt_t *const vt, unsigned int line, unsigned int first, unsigned int last)
+{
+    vt_cell_t *const row = cell_at(vt, 0, line);
+    for (unsigned int col = first; col <= last && col < vt->size.x; ++col) row[col] = blank(vt);
+}
+
+/* Blanks the other half of a wide glyph about to be overwritten at `x` */
+static void split(vt_t *const vt, unsigned int x, unsigned int y)
+{
+    vt_cell_t *const cell = cell_at(vt, x, y);
+    vt_cell_t *partner = NULL;
+    if (0 == cell->ch && x > 0) partner = cell_at(vt, x - 1, y);
+    else if (0 != cell->ch && x + 1u < vt->size.x && 0 == cell_at(vt, x + 1, y)->ch) partner = cell_at(vt, x + 1, y);
+    if (partner) *partner = (vt_cell_t){.ch = U' ', .style = partner->style};
+}
+
+static vt_cell_t *cell_at(const vt_t *const vt, unsigned int x, unsigned int y)
+{
+    return &vt->cells[(size_t) y * vt->size.x + x];
+}
+
+/* Erased cells keep current background only (back color erase) */
+static vt_cell_t blank(const vt_t *const vt)
+{
+    return (vt_cell_t){.ch = U' ', .style = {.bg = vt->style.bg}};
+}
+
+static unsigned int clamp(int value, unsigned int low, unsigned int high)
+{
+    if (value < (int) low) return low;
+    if (value > (int) high) return high;
+    return value;
+}
@@ -0,0 +1,84 @@
+#ifndef _VT_H_
+#define _VT_H_
+
+#include "display_types.h"
+#include "sgr.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define VT_MAX_SEQ 64
+#define VT_MAX_MARKS 4
+
+/* Cell of the virtual screen, `ch` 0 is the right half of a wide glyph */
+typedef struct
+{
+    uint32_t    ch;
+    sgr_state_t style;
+    uint32_t    marks[VT_MAX_MARKS]; /* combining marks printed after `ch` */
+    unsigned    mark_count;
+}
+vt_cell_t;
+
+/* What the byte stream consisted of */
+typedef struct
+{
+    size_t bytes;     /* bytes fed                                   */
+    size_t sequences; /* escape sequences                            */
+    size_t controls;  /* C0 controls: CR, LF, BS                     */
+    size_t printed;   /* characters put on the screen, REP included  */
+    size_t unknown;   /* sequences the model does not implement      */
+}
+vt_stats_t;
+
+typedef enum { VT_GROUND, VT_ESCAPE, VT_CSI } vt_parser_state_t;
+
+/*
+ * Minimal xterm compatible terminal, enough to replay output of the encoder:
+ * cursor movement, pending wrap, SGR, erasing with back color erase,
+ * insert/delete, scroll regions, REP, wide glyphs and combining marks.
+ */
+typedef struct
+{
+    vt_cell_t  *cells;
+    disp_pos_t  size;
+    disp_pos_t  cursor;
+    bool        wrap_pending;   /* last column printed, next character wraps */
+    bool        cursor_visible;
+    bool        sync_output;    /* inside of mode 2026 frame                  */
+    uint16_t    top;            /* scroll region                              */
+    uint16_t    bottom;
+    sgr_state_t style;
+    uint32_t    last_char;      /* repeated by REP                            */
+
+    vt_parser_state_t state;
+    char        seq[VT_MAX_SEQ];/* parameters of the sequence being parsed    */
+    size_t      seq_size;
+    uint32_t    codepoint;      /* UTF-8 character being decoded              */
+    unsigned    continuation;   /* UTF-8 bytes still expected                 */
+
+    vt_stats_t  frame;          /* since the last `vt_end_frame`              */
+    vt_stats_t  total;
+}
+vt_t;
+
+/* Blank screen of `size` with cursor at home */
+void vt_init(vt_t *const vt, disp_pos_t size);
+void vt_deinit(vt_t *const vt);
+
+/* Interprets bytes written to the terminal */
+void vt_feed(vt_t *const vt, const void *const data, size_t size);
+
+/* Returns stats gathered since the previous call and starts counting anew */
+vt_stats_t vt_end_frame(vt_t *const vt);
+
+const vt_cell_t *vt_cell(const vt_t *const vt, disp_pos_t pos);
+
+/*
+ * Whether the cell is seen as `ch` in `style`.
+ * Foreground and text attributes of blanks are invisible and not compared.
+ */
+bool vt_cell_shows(const vt_cell_t *const cell, uint32_t ch, const sgr_state_t *const style);
+
+#endif//_VT_H_
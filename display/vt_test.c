@@ -0,0 +1,181 @@
+#include "display.h"
+#include "vt.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COLS 80
+#define ROWS 24
+#define FRAMES 200
+
+typedef struct
+{
+    const char *name;
+    void (*draw)(display_t *const display, unsigned int frame);
+}
+scenario_t;
+
+static const style_t styles[] = {
+    {0},
+    { .fg = SGR_COLOR_BASIC(1) },
+    { .bg = SGR_COLOR_BASIC(4) },
+    { .fg = SGR_COLOR_BASIC(3), .bg = SGR_COLOR_BASIC(0), .attrs = SGR_BOLD },
+    { .attrs = SGR_UNDERLINE },
+    { .fg = SGR_COLOR_BASIC(2), .attrs = SGR_REVERSE },
+};
+
+/* random runs of few characters, so repeats and blanks are common */
+static void draw_random(display_t *const display, unsigned int frame)
+{
+    (void) frame;
+    static const wchar_t palette[] = L"  ab-|─é世\u0301";
+    for (int run = 0; run < 40; ++run)
+    {
+        const unsigned int y = rand() % display->size.y;
+        const unsigned int x = rand() % display->size.x;
+        const unsigned int length = rand() % display->size.x;
+        const wchar_t ch = palette[rand() % (sizeof(palette) / sizeof(*palette) - 1)];
+        const style_t style = styles[rand() % (sizeof(styles) / sizeof(*styles))];
+        for (unsigned int i = 0; i < length && x + i < display->size.x; ++i)
+        {
+            display_set_char(display, ch, (disp_pos_t){x + i, y});
+            display_set_style(display, style, (disp_pos_t){x + i, y});
+        }
+    }
+}
+
+/* log view: lines move up by one between a fixed header and footer */
+static void draw_log(display_t *const display, unsigned int frame)
+{
+    char line[COLS + 1];
+    display_clear(display);
+    display_fill_area(display, styles[2], (disp_area_t){{0, 0}, {display->size.x - 1, 0}});
+    display_draw_string(display, 6, "header", (disp_pos_t){1, 0}, styles[2]);
+    for (unsigned int y = 1; y + 1 < display->size.y; ++y)
+    {
+        const unsigned int number = frame + y;
+        int length = snprintf(line, sizeof(line), "%u: %.*s", number, (int) (number * 7 % 60), "lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do");
+        display_draw_string(display, length, line, (disp_pos_t){0, y}, styles[number % 4]);
+    }
+    display_draw_string(display, 6, "footer", (disp_pos_t){1, display->size.y - 1}, styles[3]);
+}
+
+/* text: UTF-8 with wide glyphs moving right, ellipsized at varying widths */
+static void draw_text(display_t *const display, unsigned int frame)
+{
+    static const char text[] = "héllo 世界, wide 表示 and cafe\u0301 with marks, narrow text mixed ー end";
+    display_clear(display);
+    for (unsigned int y = 0; y < display->size.y; ++y)
+    {
+        const unsigned int x = (frame + y) % 13;
+        const unsigned int width = (frame * 3 + y * 7) % display->size.x;
+        display_draw_text(display, sizeof(text) - 1, text, (disp_pos_t){x, y}, width,
+                styles[y % 4], y % 2 ? TEXT_ELLIPSIZE : TEXT_TRUNCATE);
+    }
+}
+
+/* marquee: every line moves one column left */
+static void draw_marquee(display_t *const display, unsigned int frame)
+{
+    for (unsigned int y = 0; y < display->size.y; ++y)
+    {
+        for (unsigned int x = 0; x < display->size.x; ++x)
+        {
+            const unsigned int i = x + frame + y * 5;
+            display_set_char(display, (i % 11 < 3) ? U' ' : U'a' + i % 26, (disp_pos_t){x, y});
+            display_set_style(display, styles[i / 11 % 3], (disp_pos_t){x, y});
+        }
+    }
+}
+
+/* replays everything written so far in the model */
+static void replay(display_t *const display, vt_t *const vt)
+{
+    char chunk[16 * 1024];
+    ssize_t bytes;
+    while ((bytes = backend_read(&display->backend, chunk, sizeof(chunk))) > 0)
+    {
+        vt_feed(vt, chunk, bytes);
+    }
+}
+
+static size_t mismatches(const display_t *const display, const vt_t *const vt)
+{
+    size_t count = 0;
+    const disp_char_t *const cells = display->buffers[display->active];
+    for (uint16_t y = 0; y < display->size.y; ++y)
+    {
+        for (uint16_t x = 0; x < display->size.x; ++x)
+        {
+            const disp_char_t cell = cells[y * display->size.x + x];
+            // right half of a wide glyph is printed with the left one
+            const disp_char_t owner = (cell.flags & CELL_CONTINUATION) ? cells[y * display->size.x + x - 1] : cell;
+            const style_t *const style = style_table_get(&display->styles, owner.style);
+            const vt_cell_t *const seen = vt_cell(vt, (disp_pos_t){x, y});
+            cluster_t cluster = {.base = cell.ch};
+            if (cell.flags & CELL_CLUSTER) cluster = *cluster_table_get(&display->clusters, cell.ch);
+            if (!vt_cell_shows(seen, cluster.base, style) || seen->mark_count != cluster.count
+                || memcmp(seen->marks, cluster.marks, cluster.count * sizeof(*cluster.marks)))
+            {
+                if (0 == count++) fprintf(stderr, "first mismatch at %u,%u\n", x, y);
+            }
+        }
+    }
+    return count;
+}
+
+static void run(const char *const caps_name, term_caps_t caps, const scenario_t *const scenario)
+{
+    const disp_pos_t size = {COLS, ROWS};
+    backend_t backend;
+    if (backend_open_memory(&backend, size)) return;
+
+    display_t display = {0};
+    vt_t vt;
+    display_set_backend(&display, backend);
+    display.encoder.caps = caps;
+    vt_init(&vt, size);
+
+    srand(1);
+    size_t bad_frames = 0;
+    for (unsigned int frame = 0; frame < FRAMES; ++frame)
+    {
+        scenario->draw(&display, frame);
+        display_render(&display);
+        replay(&display, &vt);
+        const vt_stats_t seen = vt_end_frame(&vt);
+        assert(display_frame_stats(&display, 0)->values[STAT_BYTES] == seen.bytes);
+        if (mismatches(&display, &vt)) ++bad_frames;
+        assert(!vt.sync_output);
+    }
+
+    printf("  %-8s %-5s %7zu bytes/frame %6zu sequences/frame %4zu unknown %s\n",
+            scenario->name, caps_name, vt.total.bytes / FRAMES,
+            vt.total.sequences / FRAMES, vt.total.unknown,
+            bad_frames ? "MISMATCH" : "ok");
+    assert(0 == bad_frames);
+
+    vt_deinit(&vt);
+    display_deinit(&display);
+}
+
+int main(void)
+{
+    const scenario_t scenarios[] = {
+        {"random",  draw_random},
+        {"log",     draw_log},
+        {"marquee", draw_marquee},
+        {"text",    draw_text},
+    };
+    const term_caps_t all = {.sync_output = true, .rep = true, .ech = true, .bce = true};
+
+    printf("%ux%u, %u frames replayed in the vt model:\n", COLS, ROWS, FRAMES);
+    for (size_t s = 0; s < sizeof(scenarios) / sizeof(*scenarios); ++s)
+    {
+        run("none", (term_caps_t){0}, &scenarios[s]);
+        run("all", all, &scenarios[s]);
+    }
+    return 0;
+}
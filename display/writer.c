@@ -0,0 +1,168 @@
+#include "writer.h"
+#include "clock.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+static void *writer_loop(void *arg);
+static bool write_frame(writer_t *const writer);
+
+int writer_start(writer_t *const writer, int fd)
+{
+    if (writer->running) return 0;
+
+    writer->fd = fd;
+    writer->done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (-1 == writer->done_fd)
+    {
+        perror("writer_start");
+        return errno;
+    }
+    if (-1 == sem_init(&writer->wake, 0, 0))
+    {
+        perror("writer_start");
+        const int error = errno;
+        close(writer->done_fd);
+        return error;
+    }
+    writer->collected = true;
+    atomic_store(&writer->busy, false);
+    atomic_store(&writer->stop, false);
+
+    // signals are for the event loop, thread inherits the mask
+    sigset_t all, old;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    int status = pthread_create(&writer->thread, NULL, writer_loop, writer);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    if (0 != status)
+    {
+        fprintf(stderr, "writer_start: pthread_create failed: %d\n", status);
+        sem_destroy(&writer->wake);
+        close(writer->done_fd);
+        return status;
+    }
+    writer->running = true;
+    return 0;
+}
+
+void writer_stop(writer_t *const writer)
+{
+    if (!writer->running) return;
+
+    atomic_store(&writer->stop, true);
+    sem_post(&writer->wake);
+    pthread_join(writer->thread, NULL);
+
+    sem_destroy(&writer->wake);
+    close(writer->done_fd);
+    free(writer->frame);
+    *writer = (writer_t){0};
+}
+
+int writer_submit(writer_t *const writer, encoder_t *const encoder, size_t frame)
+{
+    if (atomic_load_explicit(&writer->busy, memory_order_acquire))
+    {
+        encoder->draining = true;
+        return EAGAIN;
+    }
+
+    // writer is done with its buffer, it becomes the next one to encode into
+    char *const spare = writer->frame;
+    const size_t spare_capacity = writer->capacity;
+    writer->frame = encoder->data;
+    writer->size = encoder->size;
+    writer->capacity = encoder->capacity;
+    encoder->data = spare;
+    encoder->capacity = spare_capacity;
+
+    ++encoder->stats.frames;
+    encoder->stats.last_bytes = encoder->size;
+    encoder->stats.total_bytes += encoder->size;
+    encoder->size = 0;
+    encoder->draining = false;
+    writer->submitted = frame;
+    writer->collected = false;
+
+    atomic_store_explicit(&writer->busy, true, memory_order_release);
+    sem_post(&writer->wake);
+    return 0;
+}
+
+void writer_on_done(writer_t *const writer)
+{
+    uint64_t count;
+    (void) read(writer->done_fd, &count, sizeof(count));
+}
+
+bool writer_collect(writer_t *const writer, size_t *const frame, uint64_t *const write_ns, bool *const lost)
+{
+    if (writer->collected) return false;
+    // results are stored before `busy` is released
+    if (atomic_load_explicit(&writer->busy, memory_order_acquire)) return false;
+
+    *frame = atomic_load_explicit(&writer->written, memory_order_relaxed);
+    *write_ns = atomic_load_explicit(&writer->write_ns, memory_order_relaxed);
+    *lost = atomic_load_explicit(&writer->lost, memory_order_relaxed);
+    writer->collected = true;
+    return true;
+}
+
+static void *writer_loop(void *arg)
+{
+    writer_t *const writer = arg;
+    while (1)
+    {
+        while (-1 == sem_wait(&writer->wake) && EINTR == errno);
+
+        // frame in flight is finished before stopping
+        if (atomic_load_explicit(&writer->busy, memory_order_acquire))
+        {
+            const bool lost = !write_frame(writer);
+            atomic_store_explicit(&writer->lost, lost, memory_order_relaxed);
+            atomic_store_explicit(&writer->written, writer->submitted, memory_order_relaxed);
+
+            const uint64_t one = 1;
+            atomic_store_explicit(&writer->busy, false, memory_order_release);
+            (void) write(writer->done_fd, &one, sizeof(one));
+        }
+        if (atomic_load(&writer->stop)) break;
+    }
+    return NULL;
+}
+
+/* Returns false when the frame could not be fully written */
+static bool write_frame(writer_t *const writer)
+{
+    const uint64_t start = clock_now_ns();
+    size_t written = 0;
+    while (written < writer->size)
+    {
+        ssize_t bytes = write(writer->fd, writer->frame + written, writer->size - written);
+        if (-1 == bytes)
+        {
+            if (EINTR == errno) continue;
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                // output may be non-blocking, this thread is the one allowed to wait
+                struct pollfd pfd = {.fd = writer->fd, .events = POLLOUT};
+                (void) poll(&pfd, 1, -1);
+                continue;
+            }
+            S_LOG(LOGGER_CRITICAL, "writer: %s\n", strerror(errno));
+            break;
+        }
+        written += bytes;
+    }
+    atomic_store_explicit(&writer->write_ns, clock_now_ns() - start, memory_order_relaxed);
+    return written == writer->size;
+}
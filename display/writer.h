@@ -0,0 +1,62 @@
+#ifndef _WRITER_H_
+#define _WRITER_H_
+
+#include "encoder.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Writes encoded frames to the terminal from a dedicated thread,
+ * so the next frame can be diffed and encoded meanwhile.
+ * Frames are handed over single producer / single consumer:
+ * encoder buffer is swapped with the spare one the writer is done with.
+ */
+typedef struct
+{
+    pthread_t thread;
+    bool      running;
+    int       fd;          /* where frames are written                     */
+    int       done_fd;     /* eventfd, readable when a frame was written   */
+    sem_t     wake;        /* posted on a new frame or stop request        */
+    atomic_bool busy;      /* frame is owned by the writer thread          */
+    atomic_bool stop;
+    size_t   submitted;    /* number of the frame handed over              */
+    bool     collected;    /* last written frame was reported              */
+    atomic_size_t written; /* number of the last frame written             */
+    _Atomic uint64_t write_ns; /* how long the last frame was written       */
+    atomic_bool lost;      /* last frame did not fully reach the terminal  */
+
+    char   *frame;         /* frame being written, owned while `busy`      */
+    size_t  size;
+    size_t  capacity;
+}
+writer_t;
+
+/* Starts the thread writing to `fd`, returns 0 or errno */
+int writer_start(writer_t *const writer, int fd);
+
+/* Waits for the frame in flight and joins the thread */
+void writer_stop(writer_t *const writer);
+
+/*
+ * Hands the encoded frame number `frame` over to the writer and gives the encoder an empty buffer.
+ * Returns EAGAIN when previous frame is still being written,
+ * the frame stays in the encoder then, try again once `done_fd` is readable.
+ */
+int writer_submit(writer_t *const writer, encoder_t *const encoder, size_t frame);
+
+/* Consumes completion notifications, call when `done_fd` is readable */
+void writer_on_done(writer_t *const writer);
+
+/*
+ * Reports the last written frame once: its number, write time and whether it was lost.
+ * Returns false while it is being written or when it was reported already,
+ * call it before `writer_submit` so no frame goes unreported.
+ */
+bool writer_collect(writer_t *const writer, size_t *const frame, uint64_t *const write_ns, bool *const lost);
+
+#endif//_WRITER_H_
@@ -5,8 +5,6 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-static void draw_border(display_t *const display, wchar_t border_char, disp_pos_t pos, style_t *style);
-
 /// !!! not thread safe !!!
 ///
 /// Initializes behavior if yet not initialized,
@@ -76,37 +74,18 @@ void render_frame(const canvas_t *const canvas, display_t *const display, const
         .x = frame_transform->location.x + frame_transform->delta.x - camera_pos.x,
         .y = frame_transform->location.y + frame_transform->delta.y - camera_pos.y,
     };
-    vec2_t end = {
-        beg.x + frame_box->x - 1,
-        beg.y + frame_box->y - 1
-    };
+    if (frame_box->x <= 0 || frame_box->y <= 0) return;
 
-    for (long long y = beg.y; y <= end.y; ++y)
+    // frame draws in its own coordinates, whatever is off the screen is clipped away
+    const disp_rect_t rect = {beg.x, beg.y, frame_box->x, frame_box->y};
+    if (display_push_clip(display, rect))
     {
-        for (long long x = beg.x; x <= end.x; ++x)
-        {
-            // render
-            if (x >= 0 && y >= 0 && x < display->size.x && y < display->size.y) // inside screen
-            {
-                disp_pos_t pos = {x, y};
-
-                display_set_char(display, U' ', pos);
-                if (x == beg.x && y == beg.y) draw_border(display, U'╔', pos, *style);
-                else if (x == end.x && y == beg.y) draw_border(display, U'╗', pos, *style);
-                else if (x == end.x && y == end.y) draw_border(display, U'╝', pos, *style);
-                else if (x == beg.x && y == end.y) draw_border(display, U'╚', pos, *style);
-                else if (x == beg.x || x == end.x) draw_border(display, U'║', pos, *style);
-                else if (y == beg.y || y == end.y) draw_border(display, U'═', pos, *style);
-            }
-        }
-    }
-}
+        const disp_area_t area = {{0, 0}, {frame_box->x - 1, frame_box->y - 1}};
+        const style_id_t style_id = style ? display_intern_style(display, **style) : STYLE_DEFAULT_ID;
+        const border_set_t border = {._ = L"╔╗╝╚║═"};
 
-static void draw_border(display_t *const display, wchar_t border_char, disp_pos_t pos, style_t *style)
-{
-    if (style)
-    {
-        display_set_style(display, *style, pos);
+        display_fill_rect(display, BLANK_CELL, area);
+        display_draw_rect(display, style_id, border, area);
     }
-    display_set_char(display, border_char, pos);
+    display_pop_clip(display);
 }
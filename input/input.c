@@ -19,12 +19,6 @@
 #define INPUT_PROCESS_BUF 1024
 #define MAX_EVENTS 10
 
-typedef struct
-{
-    int temp;
-}
-buffer_t;
-
 // global struct monitoring signals
 typedef struct
 {
@@ -63,7 +57,7 @@ input_t input_init(void)
     hashmap_t *descriptors = hm_create(
         .hashfunc = hash_int,
         .key_size = sizeof(int),
-        .value_size = sizeof(buffer_t),
+        .value_size = sizeof(input_fd_handler_t),
     );
     if (!descriptors)
     {
@@ -116,32 +110,37 @@ void input_disable_mouse(void)
     fflush(stdout);
 }
 
-int input_handle_events(input_t *const input, const input_hooks_t *const hooks, void *const param)
+int input_handle_events(input_t *const input, const input_hooks_t *const hooks, void *const param, int timeout)
 {
     struct epoll_event events[MAX_EVENTS];
     int events_num = 0;
+    input->activity = false;
+
+    // queued by `input_unread`, epoll does not announce them
+    if (circbuf_avail_to_read(input->queue))
+    {
+        input->activity = true;
+        return input_process(input, hooks, param);
+    }
+
     // acquire events
-    while (true)
+    events_num = epoll_wait(input->epfd, events, MAX_EVENTS, timeout);
+    if (events_num == -1)
     {
-        events_num = epoll_wait(input->epfd, events, MAX_EVENTS, 10);
-        if (events_num != -1)
-        {
-            break; // epoll succeded
-        }
-        else if (errno != EINTR) // something went wrong
+        if (errno != EINTR) // something went wrong
         {
             perror("epoll_wait");
             return errno;
         }
         // The call was interrupted by a signal;
-        // Process signals and continue:
+        // Process signals and let the caller react on the others:
         if (s_sm.sigint)
         {
             s_sm.sigint = false;
             printf("Exit!\n");
             return -1;
         }
-        // Retry epoll_wait
+        return INPUT_SUCCESS;
     }
 
     for (int e = 0; e < events_num; e++)
@@ -151,6 +150,8 @@ int input_handle_events(input_t *const input, const input_hooks_t *const hooks,
             // process standard input
             if (events[e].data.fd == STDIN_FILENO)
             {
+                input->activity = true;
+
                 // Data available from stdin
                 int status = input_read(input);
                 if (0 != status)
@@ -164,20 +165,61 @@ int input_handle_events(input_t *const input, const input_hooks_t *const hooks,
                 {
                     return status;
                 }
+                continue;
             }
+        }
 
-            { // process buffers
-                buffer_t *buffer = hm_get(input->descriptors, &events[e].data.fd);
-                if (buffer)
-                {
-                    // write data to buffer
-                }
-            }
+        // process other registered descriptors
+        input_fd_handler_t *fd_handler = hm_get(input->descriptors, &events[e].data.fd);
+        if (fd_handler)
+        {
+            fd_handler->handler(events[e].data.fd, events[e].events, fd_handler->data);
         }
     }
     return 0;
 }
 
+int input_unread(input_t *const input, const char *const bytes, size_t size)
+{
+    if (0 == size) return INPUT_SUCCESS;
+    if (circbuf_avail_to_write(input->queue) < size)
+    {
+        return INPUT_QUEUE_IS_FULL;
+    }
+    (void) circbuf_write(input->queue, size, bytes);
+    return INPUT_SUCCESS;
+}
+
+int input_add_fd(input_t *const input, int fd, uint32_t events, input_fd_handler_t handler)
+{
+    struct epoll_event ev = {
+        .data.fd = fd,
+        .events = events,
+    };
+    if (-1 == epoll_ctl(input->epfd, EPOLL_CTL_ADD, fd, &ev))
+    {
+        perror("epoll_ctl: add");
+        return errno;
+    }
+    if (hm_insert(&input->descriptors, &fd, &handler))
+    {
+        (void) epoll_ctl(input->epfd, EPOLL_CTL_DEL, fd, NULL);
+        return INPUT_ERROR;
+    }
+    return INPUT_SUCCESS;
+}
+
+int input_remove_fd(input_t *const input, int fd)
+{
+    (void) hm_remove(input->descriptors, &fd);
+    if (-1 == epoll_ctl(input->epfd, EPOLL_CTL_DEL, fd, NULL))
+    {
+        perror("epoll_ctl: del");
+        return errno;
+    }
+    return INPUT_SUCCESS;
+}
+
 
 
 void input_display_overlay(input_t *const input, disp_pos_t pos)
@@ -6,6 +6,7 @@
 #include "hashmap.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 #define INPUT_QUEUE_SIZE  4*1024 // 4kb
 #define INPUT_BUFFER_SIZE 256
@@ -122,6 +123,14 @@ typedef struct
 }
 input_sm_t;
 
+/* Called when a descriptor registered with `input_add_fd` is ready */
+typedef struct
+{
+    void (*handler)(int fd, uint32_t events, void *const data);
+    void *data;
+}
+input_fd_handler_t;
+
 typedef struct input
 {
     input_sm_t    state_machine;
@@ -129,7 +138,8 @@ typedef struct input
     mouse_mode_t  mouse_mode;
 
     int epfd; /* epoll file descriptor */
-    hashmap_t *descriptors; /* maps fd to a buffer that receives and outputs */
+    hashmap_t *descriptors; /* maps fd to its input_fd_handler_t */
+    bool activity; /* user input was handled by the last input_handle_events call */
 }
 input_t;
 
@@ -150,8 +160,18 @@ input_t input_init(void);
 void input_deinit(input_t *const input);
 void input_enable_mouse(void);
 void input_disable_mouse(void);
-int input_handle_events(input_t *const input, const input_hooks_t *const hooks, void *const param);
+/*
+ * Waits up to `timeout` milliseconds for events (-1 blocks until any)
+ * and dispatches them to the hooks. Returns early when interrupted by a signal.
+ */
+int input_handle_events(input_t *const input, const input_hooks_t *const hooks, void *const param, int timeout);
+/* Queues bytes read from the terminal elsewhere, they are handled before any new input */
+int input_unread(input_t *const input, const char *const bytes, size_t size);
 void input_display_overlay(input_t *const input, disp_pos_t pos);
 
+/* Watches `fd` for epoll `events` within the input loop */
+int input_add_fd(input_t *const input, int fd, uint32_t events, input_fd_handler_t handler);
+int input_remove_fd(input_t *const input, int fd);
+
 
 #endif//_INPUT_H_
@@ -76,7 +76,7 @@ int main(void)
     input_t input = input_init();
     while (1)
     {
-        int status = input_handle_events(&input, &hooks, NULL);
+        int status = input_handle_events(&input, &hooks, NULL, -1);
         if (status) break;
         usleep(100);
     }
@@ -6,6 +6,17 @@
 #include "ui.h"
 
 #include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+#define TIFC_MAX_FPS 60
+
+static void on_frame_timer(int fd, uint32_t events, void *const data);
+static void on_resize(int fd, uint32_t events, void *const data);
+static void on_output_ready(int fd, uint32_t events, void *const data);
+static void print_stats(const display_t *const display);
 
 tifc_t tifc_init(void)
 {
@@ -15,6 +26,10 @@ tifc_t tifc_init(void)
         .input = input_init(),
         .ui = ui_init(),
     };
+    // keys and mouse events typed during the query are not lost
+    termcaps_typed_t typed;
+    display_query_caps(&tifc.display, &typed);
+    (void) input_unread(&tifc.input, typed.bytes, typed.size);
     return tifc;
 }
 
@@ -22,15 +37,28 @@ void tifc_deinit(tifc_t *const tifc)
 {
     input_disable_mouse();
     input_deinit(&tifc->input);
+    display_deinit(&tifc->display);
+
+    const char *stats = getenv("TIFC_STATS");
+    if (stats && 0 == strcmp(stats, "1")) print_stats(&tifc->display);
 }
 
 void tifc_render(tifc_t *const tifc)
 {
-    display_clear(&tifc->display);
     ui_render(&tifc->ui, &tifc->display);
     display_render(&tifc->display);
 }
 
+void tifc_invalidate(tifc_t *const tifc)
+{
+    display_invalidate(&tifc->display);
+}
+
+int tifc_set_max_fps(tifc_t *const tifc, unsigned int max_fps)
+{
+    return display_set_max_fps(&tifc->display, max_fps);
+}
+
 void tifc_create_ui_layout(tifc_t *const tifc)
 {
     panel_opts_t *opts = &(panel_opts_t)
@@ -100,27 +128,127 @@ int tifc_event_loop(void)
     display_set_resize_handler(&tifc.display, resize_hook);
     tifc_create_ui_layout(&tifc);
 
+    const char *threaded = getenv("TIFC_WRITER_THREAD");
+    const bool has_output = 0 == display_open_output(&tifc.display);
+    if (threaded && 0 == strcmp(threaded, "1")
+        && 0 == display_start_writer(&tifc.display))
+    {
+        // wakes up when the writer took the frame out
+        (void) input_add_fd(&tifc.input,
+            display_writer_fd(&tifc.display),
+            EPOLLIN,
+            (input_fd_handler_t){
+                .handler = on_output_ready,
+                .data = &tifc.display,
+            });
+    }
+    else if (has_output)
+    {
+        // edge triggered: wakes up once the terminal drained a blocked frame
+        (void) input_add_fd(&tifc.input,
+            display_output_fd(&tifc.display),
+            EPOLLOUT | EPOLLET,
+            (input_fd_handler_t){
+                .handler = on_output_ready,
+                .data = &tifc.display,
+            });
+    }
+
+    if (-1 != display_resize_fd(&tifc.display))
+    {
+        (void) input_add_fd(&tifc.input,
+            display_resize_fd(&tifc.display),
+            EPOLLIN,
+            (input_fd_handler_t){
+                .handler = on_resize,
+                .data = &tifc.display,
+            });
+    }
+
+    if (0 == tifc_set_max_fps(&tifc, TIFC_MAX_FPS))
+    {
+        (void) input_add_fd(&tifc.input,
+            display_frame_timer_fd(&tifc.display),
+            EPOLLIN,
+            (input_fd_handler_t){
+                .handler = on_frame_timer,
+                .data = &tifc.display,
+            });
+    }
+
     int exit_status = 0;
 
     while (1)
     {
         // input_display_overlay(&tifc.input, (disp_pos_t){.x = 0, .y = 3});
-        tifc_render(&tifc);
+        if (display_needs_render(&tifc.display)
+            && display_frame_due(&tifc.display))
+        {
+            tifc_render(&tifc);
+        }
+
+        // sleep until something happens, nothing to draw meanwhile
         input_hooks_t *hooks = &tifc.ui.hooks;
-        exit_status = input_handle_events(&tifc.input, hooks, &tifc);
+        exit_status = input_handle_events(&tifc.input, hooks, &tifc, -1);
         if (0 != exit_status)
         {
-            display_erase();
+            display_erase(&tifc.display);
             break;
         }
+
+        // hooks could change any state, draw it
+        if (tifc.input.activity)
+        {
+            tifc_invalidate(&tifc);
+        }
     }
 
     tifc_deinit(&tifc);
     return exit_status;
 }
 
+static void on_frame_timer(int fd, uint32_t events, void *const data)
+{
+    (void) fd; (void) events;
+    display_on_frame_timer((display_t*) data);
+}
+
+static void on_resize(int fd, uint32_t events, void *const data)
+{
+    (void) fd; (void) events;
+    display_on_resize_signal((display_t*) data);
+}
+
+static void on_output_ready(int fd, uint32_t events, void *const data)
+{
+    (void) fd; (void) events;
+    display_on_output_ready((display_t*) data);
+}
+
 int main(void)
 {
     return tifc_event_loop();
 }
 
+/* Summary of the recent frames, shows what a slow layout spends its time on */
+static void print_stats(const display_t *const display)
+{
+    static const char *const names[STAT_METRICS] = {
+        [STAT_CELLS_SCANNED] = "cells scanned",
+        [STAT_CELLS_CHANGED] = "cells changed",
+        [STAT_BYTES]         = "bytes",
+        [STAT_SEQUENCES]     = "sequences",
+        [STAT_ENCODE_NS]     = "encode ns",
+        [STAT_WRITE_NS]      = "write ns",
+    };
+
+    fprintf(stderr, "%-14s %10s %10s %10s %10s %10s\n", "last frames", "min", "p50", "p90", "p99", "max");
+    for (int metric = 0; metric < STAT_METRICS; ++metric)
+    {
+        const stats_histogram_t h = display_stats_histogram(display, metric);
+        fprintf(stderr, "%-14s %10lu %10lu %10lu %10lu %10lu\n", names[metric],
+                (unsigned long) h.min, (unsigned long) h.p50, (unsigned long) h.p90,
+                (unsigned long) h.p99, (unsigned long) h.max);
+    }
+    fprintf(stderr, "missed deadlines: %zu\n", display_missed_deadlines(display));
+}
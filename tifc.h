@@ -13,4 +13,10 @@ typedef struct tifc
 }
 tifc_t;
 
+/* Requests a frame, call it when data shown by the ui changes */
+void tifc_invalidate(tifc_t *const tifc);
+
+/* Caps frames per second, invalidations in between are coalesced */
+int tifc_set_max_fps(tifc_t *const tifc, unsigned int max_fps);
+
 #endif /* _TIFC_H_ */
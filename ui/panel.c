@@ -49,13 +49,11 @@ static disp_area_t
 calc_panel_area(const panel_layout_t *const layout,
                 disp_area_t *const bounds);
 static void
-panel_draw_title(const panel_t *panel,
-                 display_t *const display)
-{
-    disp_area_t title_area = panel->area;
-    title_area.second.y = title_area.first.y;
-    display_draw_string_centered(display, panel->title_size, panel->title, title_area, panel->style);
-}
+panel_draw_chrome(panel_t *const panel,
+                  display_t *const display);
+static void
+panel_blit_chrome(const panel_t *const panel,
+                  display_t *const display);
 
 void panel_init(panel_t *const panel,
                 const panel_opts_t *const opts)
@@ -100,15 +98,18 @@ void panel_deinit(panel_t *const panel)
     if (PANEL_CONTENT_TYPE_RAW == panel->content_type)
     {
         // TODO: deallocate raw panel
+        surface_deinit(&panel->chrome);
         return;
     }
     grid_deinit(&panel->content.grid);
+    surface_deinit(&panel->chrome);
 }
 
 void panel_recalculate_layout(panel_t *panel,
                               disp_area_t *const bounds)
 {
     panel->area = calc_panel_area(&panel->layout, bounds);
+    panel->chrome_valid = false;
 
     if (IS_INVALID_AREA(&panel->area)) return;
 
@@ -122,7 +123,7 @@ void panel_recalculate_layout(panel_t *panel,
     grid_recalculate_layout(&panel->content.grid, &panel->area); // TODO
 }
 
-void panel_render(const panel_t *panel,
+void panel_render(panel_t *const panel,
                   display_t *const display)
 {
     assert(panel);
@@ -130,11 +131,8 @@ void panel_render(const panel_t *panel,
     // dont render panel if has no valid area
     if (IS_INVALID_AREA(&panel->area)) return;
 
-    disp_area_t panel_area = panel->area;
-    border_set_t border = {._ = L"╭╮╯╰│─"};
-    display_draw_border(display, panel->style, border, panel_area);
-    // display_fill_area(display, panel->style, panel_area);
-    panel_draw_title(panel, display);
+    if (!panel->chrome_valid) panel_draw_chrome(panel, display);
+    panel_blit_chrome(panel, display);
 
     // render temporary TODO
     if (PANEL_CONTENT_TYPE_RAW == panel->content_type)
@@ -146,6 +144,59 @@ void panel_render(const panel_t *panel,
     grid_render(&panel->content.grid, display);
 }
 
+static void
+panel_draw_chrome(panel_t *const panel,
+                  display_t *const display)
+{
+    const disp_pos_t size = {
+        panel->area.second.x - panel->area.first.x + 1,
+        panel->area.second.y - panel->area.first.y + 1,
+    };
+    const style_id_t style = display_intern_style(display, panel->style);
+    border_set_t border = {._ = L"╭╮╯╰│─"};
+
+    surface_resize(&panel->chrome, size);
+    surface_draw_border(&panel->chrome, style, border,
+            (disp_area_t){{0, 0}, {size.x - 1, size.y - 1}});
+
+    // title is centered on the top border, ellipsized when too long
+    const unsigned int hmax = size.x - 1;
+    bool ellipsis = false;
+    const unsigned int title_size = text_fit(panel->title, panel->title_size, hmax, TEXT_ELLIPSIZE, &ellipsis);
+    const unsigned int width = text_width(panel->title, title_size);
+    disp_pos_t pos = {0, 0};
+    if (width < hmax && !ellipsis) pos.x = (hmax - width) / 2;
+    surface_draw_string(&panel->chrome, title_size, panel->title, pos, style, &display->clusters);
+    if (ellipsis)
+    {
+        surface_set(&panel->chrome, (disp_char_t){.ch = TEXT_ELLIPSIS, .style = style}, (disp_pos_t){pos.x + width, 0});
+    }
+
+    panel->chrome_valid = true;
+}
+
+/* Only the edges are copied, inside belongs to the content */
+static void
+panel_blit_chrome(const panel_t *const panel,
+                  display_t *const display)
+{
+    const surface_t *const chrome = &panel->chrome;
+    const unsigned int right = chrome->size.x - 1;
+    const unsigned int bottom = chrome->size.y - 1;
+    const disp_rect_t rect = {
+        panel->area.first.x, panel->area.first.y,
+        chrome->size.x, chrome->size.y,
+    };
+
+    if (display_push_clip(display, rect))
+    {
+        display_blit(display, chrome, (disp_area_t){{0, 0}, {right, 0}}, (disp_pos_t){0, 0});
+        display_blit(display, chrome, (disp_area_t){{0, bottom}, {right, bottom}}, (disp_pos_t){0, bottom});
+        display_blit(display, chrome, (disp_area_t){{0, 1}, {0, bottom}}, (disp_pos_t){0, 1});
+        display_blit(display, chrome, (disp_area_t){{right, 1}, {right, bottom}}, (disp_pos_t){right, 1});
+    }
+    display_pop_clip(display);
+}
 
 static disp_area_t
 calc_panel_area(const panel_layout_t *const layout,
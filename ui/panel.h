@@ -27,6 +27,8 @@ typedef struct
     panel_layout_t  layout;
     style_t         style;
     disp_area_t     area;
+    surface_t       chrome;       // border and title, drawn once per layout
+    bool            chrome_valid;
 
     panel_content_type_t content_type;
     union content {
@@ -57,7 +59,7 @@ void panel_init(panel_t *const panel, const panel_opts_t *const opts);
 
 void panel_deinit(panel_t *const panel);
 
-void panel_render(const panel_t *panel, display_t *const display);
+void panel_render(panel_t *const panel, display_t *const display);
 
 void panel_recalculate_layout(panel_t *panel,
                               disp_area_t *const bounds);
@@ -69,6 +69,7 @@ void ui_recalculate_layout(ui_t *const ui, const display_t *const display)
             panel_recalculate_layout(panel, &bounds);
         }
     }
+    ui->relayout = true;
 }
 
 void ui_resize_hook(const display_t *const display, void *data)
@@ -76,11 +77,15 @@ void ui_resize_hook(const display_t *const display, void *data)
     ui_recalculate_layout((ui_t*)data, display);
 }
 
-void ui_render(const ui_t *const ui,
+void ui_render(ui_t *const ui,
                display_t *const display)
 {
-    (void) ui;
-    // TODO
+    // unchanged cells are skipped by the display, only moved panels need a clean screen
+    if (ui->relayout)
+    {
+        display_clear(display);
+        ui->relayout = false;
+    }
 
     size_t size = sparse_size(ui->panels);
     for (size_t i = 0; i < size; ++i)
@@ -11,6 +11,7 @@ typedef struct
     input_hooks_t hooks;
     sparse_t     *panels;
     sparse_t     *items;
+    bool          relayout; /* panels moved, screen they left is cleared */
 }
 ui_t;
 
@@ -23,8 +24,9 @@ ui_recalculate_layout(ui_t *const ui,
 void
 ui_resize_hook(const display_t *const display,
         void *const data);
+/* Draws panels over the last frame, screen is cleared only after a relayout */
 void
-ui_render(const ui_t *const ui,
+ui_render(ui_t *const ui,
         display_t *const display);
 
 